@@ -1,70 +1,249 @@
 #include "behavior.hpp"
 #include "top.hpp"
-#include <functional>
+#include "commandline.hpp"
+#include "tlm.hpp"
+#include "kernel.hpp"
+#include "checkpoint.hpp"
 
 using namespace sc_core;
 
 namespace {
   constexpr char const* const MSGID{ "/Doulos/Example/tracing" };
+  [[maybe_unused]] const bool described
+  { Commandline::describe( "-inject=PERCENT", "Inject errors at a range of PERCENT (1..100)" ) };
+}
+
+template<typename T>
+std::unique_ptr<Behavior_base<T>> Behavior_base<T>::create( sc_core::sc_module_name instance, const std::string& kernel )
+{
+  // Each kernel has its own instantiation of Behavior_module
+  std::unique_ptr<Behavior_base> result;
+  Kernel_registry::for_each( [&]( auto each ){
+    using K = decltype( each );
+    if( kernel == K::name ) result = std::make_unique<Behavior_module<T,K>>( instance );
+  } );
+  return result;
+}
+
+template<typename T>
+Behavior_base<T>::Behavior_base( sc_core::sc_module_name instance )
+: Profiled_module( instance )
+, rng( name() )
+{
+  loosely_timed = Commandline::has( "-quantum" );
+
+  // Manage error injection
+  inject = Commandline::has( "-inject" );
+  if( inject ) {
+    weight = Commandline::get<int>( "-inject", weight );
+    if( weight > 100 ) weight %= 100;
+    if( weight <= 0  ) {
+      REPORT( WARNING, "Weight should be a number 1..100" );
+      weight = 1;
+    }
+  }
+
+  // Checkpoints are taken between samples, so no kernel holds a value
+  Checkpoint::add( this
+  , [this]( Checkpoint::Writer& out ) {
+      out.put( rng );
+      out.put( recv_value );
+      out.put( send_value );
+    }
+  , [this]( Checkpoint::Reader& in ) {
+      in.get( rng );
+      in.get( recv_value );
+      in.get( send_value );
+    } );
 }
 
-Behavior_module::Behavior_module( sc_core::sc_module_name instance )
-: sc_module( instance )
+template<typename T, typename Kernel>
+Behavior_module<T,Kernel>::Behavior_module( sc_core::sc_module_name instance )
+: Base( instance )
 {
   SC_HAS_PROCESS( Behavior_module );
-  SC_THREAD( behavior_thread );
+  if( Commandline::has( "-methods" ) ) {
+    SC_METHOD( behavior_method );
+  } else {
+    SC_THREAD( behavior_thread );
+    SC_THREAD( burst_thread );
+  }
+  if( inject and not Kernel::injects ) {
+    REPORT( WARNING, "Kernel " << Kernel::name << " does not inject errors" );
+  }
 }
 
-void Behavior_module::start_of_simulation()
+template<typename T>
+void Behavior_base<T>::end_of_elaboration()
+{
+  bool samples = recv_port.size() != 0 and send_port.size() != 0;
+  bool bursts  = burst_recv_port.size() != 0 and burst_send_port.size() != 0;
+  if( samples == bursts ) {
+    SC_REPORT_FATAL( MSGID, "Exactly one of the sample or burst port pairs must be connected" );
+  }
+}
+
+template<typename T>
+void Behavior_base<T>::start_of_simulation()
 {
   const auto& trace_file { Top_module::trace_file() };
   if( trace_file != nullptr ) {
     auto prefix = std::string(name()) + ".";
-    sc_trace( trace_file, recv_value, prefix + "recv_value" );
-    sc_trace( trace_file, send_value, prefix + "send_value" );
+    Top_module::trace( recv_value, prefix + "recv_value" );
+    Top_module::trace( send_value, prefix + "send_value" );
   }
 }
 
-#include <random>
-#include "commandline.hpp"
-void Behavior_module::behavior_thread()
+template<typename T, typename Kernel>
+T Behavior_module<T,Kernel>::process( const T& value )
 {
-  INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
+  return perturb( Kernel::transform( value ) );
+}
 
-  // Manage error injection
-  static std::default_random_engine gen;
-  int weight = 50; // Percent
-  int inject = Commandline::has_opt("-inject");
-  if( inject != 0 ) {
-    std::string arg = sc_argv()[ inject ];
-    if( auto pos = arg.find_first_of("="); pos != std::string::npos ) {
-      weight = std::stoi( arg.substr( pos + 1 ) );
-      if( weight > 100 ) weight %= 100;
-      if( weight <= 0  ) {
-        REPORT( WARNING, "Weight should be a number 1..100" );
-        weight = 1;
-      }
+template<typename T, typename Kernel>
+T Behavior_module<T,Kernel>::perturb( T result )
+{
+  // Check to see if an error should be injected
+  if( inject ) {
+    if( auto bit = Kernel::template inject_bit<T>( rng, weight ); bit >= 0 ) {
+      // Perturb value by one bit
+      DEBUG( "INJECTING bit " << bit );
+      Payload<T>::flip( result, bit );
     }
+  }
+  return result;
+}
+
+// Burst latency is the same as for individual samples, but once per burst
+template<typename T, typename Kernel>
+Burst<T> Behavior_module<T,Kernel>::process( const Burst<T>& recv )
+{
+  Burst<T> send{ recv.size() };
+  send.set_timing( recv.start() + Kernel::latency(), recv.period() );
+  results.resize( recv.size() );
+  Kernel::transform( recv.begin(), results.data(), recv.size() );
+  for( size_t i = 0; i != recv.size(); ++i ) {
+    recv_value = recv[ i ];
+    send_value = perturb( results[ i ] );
+    send.push_back( send_value );
+  }
+  DEBUG( "Processed " << recv << " into " << send );
+  return send;
+}
+
+template<typename T>
+void Behavior_base<T>::starting( const char* process_name )
+{
+  INFO( NONE, "Starting " << process_name );
+  if( inject ) {
     INFO( NONE, "Inject bit-errors at " << weight << "%" );
   }
-  std::uniform_int_distribution<int> rand_event(0,100);
-  std::uniform_int_distribution<int> rand_bit(0,15);
+}
+
+template<typename T, typename Kernel>
+void Behavior_module<T,Kernel>::behavior_thread()
+{
+  if( recv_port.size() == 0 ) return; // Burst mode
+  starting( __PRETTY_FUNCTION__ );
 
   for(;;) {
     wait( recv_port->value_changed_event() );
-    wait( 2.5_ns );
+    wait( Kernel::read_delay() );
     recv_value = recv_port->read();
-    wait( 2.5_ns );
-    send_value = ~std::hash<Data_t>{}( recv_value ) & ~Data_t();
-    // Check to see if an error should be injected
-    if( inject != 0 and rand_event(gen) <= weight ) {
-      // Perturb value by one bit
-      auto bit = rand_bit(gen);
-      DEBUG( "INJECTING bit " << bit );
-      send_value ^= 1u<<bit;
-    }
+    wait( Kernel::process_delay() );
+    send_value = process( recv_value );
     send_port->write( send_value );
   }
 }
 
+template<typename T, typename Kernel>
+void Behavior_module<T,Kernel>::burst_thread()
+{
+  if( burst_recv_port.size() == 0 ) return; // Sample mode
+  starting( __PRETTY_FUNCTION__ );
+
+  // When loosely-timed, the latency is only annotated and accumulated locally
+  for(;;) {
+    wait( burst_recv_port->value_changed_event() );
+    Burst<T> recv;
+    if( loosely_timed ) {
+      qk.reset(); // Waiting for the burst synchronized us
+      recv = burst_recv_port->read();
+      qk.inc( Kernel::latency() );
+    } else {
+      wait( Kernel::read_delay() );
+      recv = burst_recv_port->read();
+      wait( Kernel::process_delay() );
+    }
+    burst_send_port->write( process( recv ) );
+    if( loosely_timed and qk.need_sync() ) qk.sync();
+  }
+}
+
+// State machine with the same timing as behavior_thread() or burst_thread()
+template<typename T, typename Kernel>
+void Behavior_module<T,Kernel>::behavior_method()
+{
+  Profile::Scope scope;
+  const bool bursts = burst_recv_port.size() != 0;
+  const sc_event& input = bursts ? burst_recv_port->value_changed_event()
+                                 : recv_port->value_changed_event();
+  switch( phase ) {
+    case Phase::start:
+      starting( __PRETTY_FUNCTION__ );
+      phase = Phase::input;
+      next_trigger( input );
+      break;
+    case Phase::input:
+      if( bursts and loosely_timed ) {
+        qk.reset(); // Waiting for the burst synchronized us
+        recv_burst = burst_recv_port->read();
+        qk.inc( Kernel::latency() );
+        burst_send_port->write( process( recv_burst ) );
+        if( qk.need_sync() ) {
+          phase = Phase::sync;
+          next_trigger( qk.get_local_time() );
+        } else {
+          next_trigger( input );
+        }
+        break;
+      }
+      phase = Phase::read;
+      next_trigger( Kernel::read_delay() );
+      break;
+    case Phase::read:
+      if( bursts ) {
+        recv_burst = burst_recv_port->read();
+      } else {
+        recv_value = recv_port->read();
+      }
+      phase = Phase::send;
+      next_trigger( Kernel::process_delay() );
+      break;
+    case Phase::send:
+      if( bursts ) {
+        burst_send_port->write( process( recv_burst ) );
+      } else {
+        send_value = process( recv_value );
+        send_port->write( send_value );
+      }
+      phase = Phase::input;
+      next_trigger( input );
+      break;
+    case Phase::sync: // Equivalent of qk.sync() completing
+      qk.reset();
+      phase = Phase::input;
+      next_trigger( input );
+      break;
+  }
+}
+
+// One instantiation per Payload_registry::List entry
+template struct Behavior_base<uint16_t>;
+template struct Behavior_base<uint8_t>;
+template struct Behavior_base<uint32_t>;
+template struct Behavior_base<uint64_t>;
+template struct Behavior_base<sc_dt::sc_bv<512>>;
+template struct Behavior_base<sc_dt::sc_biguint<512>>;
+
 // TAF!
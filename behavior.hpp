@@ -2,15 +2,61 @@
 
 #include "systemc.hpp"
 #include "common.hpp"
+#include "burst.hpp"
+#include "random.hpp"
+#include "profile.hpp"
+#include "payload.hpp"
+#include <tlm_utils/tlm_quantumkeeper.h>
+#include <memory>
+#include <vector>
 
-struct Behavior_module : sc_core::sc_module
+// Ports and options common to every kernel (see kernel.hpp)
+template<typename T>
+struct Behavior_base : Profiled_module
 {
-  sc_core::sc_in<Data_t>  recv_port { "recv_port" };
-  sc_core::sc_out<Data_t> send_port { "send_port" };
-  Behavior_module( sc_core::sc_module_name instance );
+  // Connect either the sample ports or the burst ports
+  constexpr static auto BIND = sc_core::SC_ZERO_OR_MORE_BOUND;
+  sc_core::sc_port<sc_core::sc_signal_in_if<T>,1,BIND>           recv_port       { "recv_port" };
+  sc_core::sc_port<sc_core::sc_signal_inout_if<T>,1,BIND>        send_port       { "send_port" };
+  sc_core::sc_port<sc_core::sc_signal_in_if<Burst<T>>,1,BIND>    burst_recv_port { "burst_recv_port" };
+  sc_core::sc_port<sc_core::sc_signal_inout_if<Burst<T>>,1,BIND> burst_send_port { "burst_send_port" };
+  static std::unique_ptr<Behavior_base> create( sc_core::sc_module_name instance, const std::string& kernel ); ///< Named kernel
   void start_of_simulation();
+protected:
+  Behavior_base( sc_core::sc_module_name instance );
+  void end_of_elaboration();
+  void starting( const char* process_name );
+  bool   loosely_timed{ false }; // -quantum
+  bool   inject{ false }; // -inject
+  int    weight{ 50 };    // Percent
+  Random rng;             // Error injection stream
+  T      recv_value{};
+  T      send_value{ Payload<T>::invert( T() ) };
+};
+
+template<typename T, typename Kernel>
+struct Behavior_module : Behavior_base<T>
+{
+  Behavior_module( sc_core::sc_module_name instance );
   void behavior_thread();
+  void burst_thread();
+  void behavior_method(); // -methods replacement for both threads
 private:
-  Data_t recv_value{ 0 };
-  Data_t send_value{ 0xFFFFu };
+  using Base = Behavior_base<T>;
+  using Base::recv_port;  using Base::send_port;
+  using Base::burst_recv_port; using Base::burst_send_port;
+  using Base::loosely_timed; using Base::inject; using Base::weight; using Base::rng;
+  using Base::recv_value; using Base::send_value; using Base::starting;
+  using Base::wait; using Base::next_trigger;
+  T process( const T& value ); // Transform and possibly inject an error
+  T perturb( T result ); // Possibly inject an error
+  Burst<T> process( const Burst<T>& recv ); // Process every sample of a burst
+  std::vector<T> results; // Batch transform of a burst
+  // behavior_method() state
+  enum class Phase { start, input, read, send, sync };
+  Phase    phase{ Phase::start };
+  Burst<T> recv_burst;
+  tlm_utils::tlm_quantumkeeper qk;
 };
+
+//TAF!
@@ -0,0 +1,166 @@
+#pragma once
+
+/** @class Broadcast
+
+@brief Single-writer channel observed by any number of readers
+
+Each value written is stored once. Readers observe it through lightweight
+read-only interfaces that refer back to the channel:
+
+- signal readers (`sc_signal_in_if<T>`) share the current value and a
+  single value-changed event, so a write costs one update regardless of
+  fanout;
+- FIFO readers (`sc_fifo_in_if<T>`) each keep a cursor into a shared ring
+  of `depth` values.
+
+As with `sc_signal` and `sc_fifo`, written values become visible after the
+update phase.
+
+Only attached FIFO readers hold back the writer; attach the readers that
+are actually connected. `write()` always updates the signal value, but
+queues the value for FIFO readers only if every attached reader has room
+(the same as `sc_fifo::nb_write`).
+
+Usage
+-----
+
+```c++
+Broadcast<int> channel{ "channel", depth };
+channel.resize( signals, fifos );
+export.bind( channel.signal_reader( i ) );
+channel.attach( j ); // FIFO reader j is in use
+channel.write( value );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+template<typename T>
+class Broadcast : public sc_core::sc_prim_channel
+{
+public:
+  explicit Broadcast( const char* name, size_t depth = 1 )
+  : sc_prim_channel( name )
+  , m_ring( depth )
+  {
+    sc_assert( depth > 0 );
+  }
+
+  void resize( size_t signals, size_t fifos ) ///< Create readers
+  {
+    while( m_signals.size() < signals ) m_signals.push_back( std::make_unique<Signal_reader>( *this ) );
+    while( m_fifos.size() < fifos ) m_fifos.push_back( std::make_unique<Fifo_reader>( *this ) );
+  }
+  sc_core::sc_signal_in_if<T>& signal_reader( size_t i ) { return *m_signals.at( i ); }
+  sc_core::sc_fifo_in_if<T>&   fifo_reader( size_t i ) { return *m_fifos.at( i ); }
+  void attach( size_t i ) ///< FIFO reader i consumes values
+  {
+    auto& reader = *m_fifos.at( i );
+    if( not reader.m_attached ) ++m_attached;
+    reader.m_attached = true;
+    reader.m_cursor   = m_committed;
+  }
+
+  bool write( const T& value ) ///< Returns false if not queued for FIFO readers
+  {
+    m_next = value;
+    m_signal_pending = true;
+    request_update();
+    if( m_attached == 0 ) return true;
+    if( m_written - oldest() == m_ring.size() ) return false;
+    m_ring[ m_written % m_ring.size() ] = value;
+    ++m_written;
+    return true;
+  }
+
+  const T& read() const { return m_current; }
+  const sc_core::sc_event& value_changed_event() const { return m_value_changed_event; }
+  const sc_core::sc_event& data_written_event() const { return m_data_written_event; }
+
+private:
+  struct Signal_reader : sc_core::sc_signal_in_if<T>
+  {
+    explicit Signal_reader( Broadcast& channel ) : m_channel( channel ) {}
+    const sc_core::sc_event& value_changed_event() const override { return m_channel.m_value_changed_event; }
+    const sc_core::sc_event& default_event() const override { return m_channel.m_value_changed_event; }
+    const T& read() const override { return m_channel.m_current; }
+    const T& get_data_ref() const override { return m_channel.m_current; }
+    bool event() const override { return m_channel.m_change_stamp == sc_core::sc_delta_count(); }
+    Broadcast& m_channel;
+  };
+
+  struct Fifo_reader : sc_core::sc_fifo_in_if<T>
+  {
+    explicit Fifo_reader( Broadcast& channel ) : m_channel( channel ) {}
+    bool nb_read( T& value ) override
+    {
+      if( m_cursor == m_channel.m_committed ) return false;
+      value = m_channel.m_ring[ m_cursor % m_channel.m_ring.size() ];
+      ++m_cursor;
+      return true;
+    }
+    void read( T& value ) override
+    {
+      while( not nb_read( value ) ) Profile::wait( m_channel.m_data_written_event );
+    }
+    T read() override
+    {
+      T value;
+      read( value );
+      return value;
+    }
+    int num_available() const override { return static_cast<int>( m_channel.m_committed - m_cursor ); }
+    const sc_core::sc_event& data_written_event() const override { return m_channel.m_data_written_event; }
+    const sc_core::sc_event& default_event() const override { return m_channel.m_data_written_event; }
+    Broadcast& m_channel;
+    uint64_t   m_cursor{ 0 };
+    bool       m_attached{ false };
+  };
+
+  uint64_t oldest() const ///< Oldest value still needed by a FIFO reader
+  {
+    auto result = m_written;
+    for( const auto& reader : m_fifos ) {
+      if( reader->m_attached ) result = std::min( result, reader->m_cursor );
+    }
+    return result;
+  }
+
+  void update() override
+  {
+    if( m_committed != m_written ) {
+      m_committed = m_written;
+      m_data_written_event.notify( sc_core::SC_ZERO_TIME );
+    }
+    if( m_signal_pending ) {
+      m_signal_pending = false;
+      if( not ( m_next == m_current ) ) {
+        m_current = m_next;
+        m_change_stamp = sc_core::sc_delta_count() + 1; // Delta in which readers see it
+        m_value_changed_event.notify( sc_core::SC_ZERO_TIME );
+      }
+    }
+  }
+
+  std::vector<T>    m_ring;
+  uint64_t          m_written{ 0 };   ///< Values queued, including this delta
+  uint64_t          m_committed{ 0 }; ///< Values visible to FIFO readers
+  T                 m_current{};
+  T                 m_next{};
+  size_t            m_attached{ 0 };  ///< FIFO readers in use
+  bool              m_signal_pending{ false };
+  uint64_t          m_change_stamp{ ~uint64_t( 0 ) };
+  sc_core::sc_event m_value_changed_event;
+  sc_core::sc_event m_data_written_event;
+  std::vector<std::unique_ptr<Signal_reader>> m_signals;
+  std::vector<std::unique_ptr<Fifo_reader>>   m_fifos;
+};
+
+// TAF!
@@ -0,0 +1,138 @@
+#pragma once
+
+/** @class Burst
+
+@brief Block of samples transferred as a single transaction
+
+A Burst is a reference-counted handle to a pooled block of samples, so
+copying it into FIFOs and signals (e.g. through `Splitter_module<Burst<T>>`)
+never copies the samples. Blocks return to the pool when the last handle
+is destroyed.
+
+Each burst carries annotated timing: the nominal time of its first sample
+and the sample period. Every new burst also gets a unique sequence number,
+which serves as its identity for `sc_signal` change detection and as its
+traced value.
+
+Usage
+-----
+
+```c++
+Burst<Data_t> burst{ size };
+burst.set_timing( start, period );
+for( ... ) burst.push_back( value );
+fifo.write( burst );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "common.hpp"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+template<typename T>
+class Burst
+{
+public:
+  Burst() = default; ///< Empty burst
+  explicit Burst( size_t capacity ) ///< New burst from pool
+  : m_block( acquire() )
+  , m_sequence( ++s_sequence )
+  {
+    m_block->samples.clear();
+    m_block->samples.reserve( capacity );
+    m_block->start  = sc_core::SC_ZERO_TIME;
+    m_block->period = sc_core::SC_ZERO_TIME;
+  }
+  Burst( const Burst& that )
+  : m_block( that.m_block )
+  , m_sequence( that.m_sequence )
+  {
+    if( m_block != nullptr ) ++m_block->refs;
+  }
+  Burst& operator=( const Burst& that )
+  {
+    if( that.m_block != nullptr ) ++that.m_block->refs;
+    release();
+    m_block    = that.m_block;
+    m_sequence = that.m_sequence;
+    return *this;
+  }
+  ~Burst() { release(); }
+
+  // Filling is only allowed before the burst is shared
+  void push_back( const T& value )
+  {
+    sc_assert( m_block != nullptr and m_block->refs == 1 );
+    m_block->samples.push_back( value );
+  }
+  void set_timing( const sc_core::sc_time& start, const sc_core::sc_time& period )
+  {
+    sc_assert( m_block != nullptr and m_block->refs == 1 );
+    m_block->start  = start;
+    m_block->period = period;
+  }
+
+  size_t   size() const { return m_block == nullptr ? 0u : m_block->samples.size(); }
+  bool     empty() const { return size() == 0; }
+  const T& operator[]( size_t i ) const { return m_block->samples[ i ]; }
+  const T* begin() const { return m_block == nullptr ? nullptr : m_block->samples.data(); }
+  const T* end() const { return begin() + size(); }
+  uint64_t sequence() const { return m_sequence; }
+  sc_core::sc_time start() const { return m_block == nullptr ? sc_core::SC_ZERO_TIME : m_block->start; }
+  sc_core::sc_time period() const { return m_block == nullptr ? sc_core::SC_ZERO_TIME : m_block->period; }
+  sc_core::sc_time time_of( size_t i ) const { return start() + period() * double( i ); } ///< Annotated time of sample i
+
+  bool operator==( const Burst& that ) const { return m_sequence == that.m_sequence; }
+  bool operator!=( const Burst& that ) const { return not ( *this == that ); }
+  friend std::ostream& operator<<( std::ostream& os, const Burst& burst )
+  {
+    return os << "burst#" << std::dec << burst.m_sequence << "[" << burst.size() << "]";
+  }
+  friend void sc_trace( sc_core::sc_trace_file* tf, const Burst& burst, const std::string& name )
+  {
+    sc_core::sc_trace( tf, burst.m_sequence, name );
+  }
+
+private:
+  struct Block {
+    std::vector<T>   samples;
+    sc_core::sc_time start, period;
+    size_t           refs{ 0 };
+    Block*           next{ nullptr }; ///< Free list
+  };
+  static Block* acquire()
+  {
+    if( s_free == nullptr ) {
+      s_blocks.push_back( std::make_unique<Block>() );
+      s_free = s_blocks.back().get();
+    }
+    auto block = s_free;
+    s_free = block->next;
+    block->next = nullptr;
+    block->refs = 1;
+    return block;
+  }
+  void release()
+  {
+    if( m_block != nullptr and --m_block->refs == 0 ) {
+      m_block->next = s_free;
+      s_free = m_block;
+    }
+    m_block = nullptr;
+  }
+  Block*   m_block{ nullptr };
+  uint64_t m_sequence{ 0 };
+  inline static std::vector<std::unique_ptr<Block>> s_blocks; ///< Owns the pool
+  inline static Block*                              s_free{ nullptr };
+  inline static uint64_t                            s_sequence{ 0 };
+};
+
+using Burst_t = Burst<Data_t>;
+
+// TAF!
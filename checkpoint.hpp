@@ -0,0 +1,297 @@
+#pragma once
+
+/** @class Checkpoint
+
+@brief Saves testbench state so that a long run can resume part-way
+
+SystemC cannot save the stacks of its processes, so a checkpoint holds the
+testbench *data* instead, taken at a point where no process holds state
+of its own. `Stimulus_module` takes it at a sample boundary once
+`-checkpoint-at=TIME` or `-checkpoint-after=SAMPLES` is reached. The
+pending sample or burst has been generated, and the previous one has
+passed through the design. The checkpoint is written to
+`-checkpoint=FILE` (default checkpoint.bin).
+
+`-restore=FILE` elaborates as usual, then loads every section before
+`sc_start()`. Processes start from their beginning with the restored
+state, and the stimulus first waits until the time of the checkpoint.
+Only the window of interest then needs re-simulating, e.g. with
+`-debugall -trace`. Signals start from their default values.
+
+Modules register a section in their constructor. Sections are keyed by
+instance name and hold raw values (wide payloads as stored by `Payload`),
+so checkpoints are only portable between identical builds and
+configurations. A section that does not
+consume exactly what was saved is reported as an error.
+
+With `-lanes=K`, the checkpoint is taken at the first lane's sample
+boundary; other lanes resume from the sample they hold at that moment,
+so exact replays of a failing window are best taken with one lane.
+
+Usage
+-----
+
+```c++
+Checkpoint::add( this                         // In the constructor
+               , [this]( Checkpoint::Writer& out ){ out.put( count ); out.put( rng ); }
+               , [this]( Checkpoint::Reader& in  ){ in.get( count );  in.get( rng ); } );
+...
+if( Checkpoint::due( samples ) ) Checkpoint::save( samples ); // At a quiet point
+...
+if( Checkpoint::restoring() ) Checkpoint::restore(); // Before sc_start()
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "commandline.hpp"
+#include "report.hpp"
+#include "burst.hpp"
+#include "payload.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct Checkpoint
+{
+  class Writer
+  {
+  public:
+    template<typename T>
+    void put( const T& value )
+    {
+      if constexpr( std::is_trivially_copyable_v<T> ) {
+        m_bytes.append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+      } else {
+        unsigned char bytes[ Payload<T>::bytes ];
+        Payload<T>::store( value, bytes );
+        m_bytes.append( reinterpret_cast<const char*>( bytes ), sizeof( bytes ) );
+      }
+    }
+    void put( const std::string& text )
+    {
+      put( uint64_t( text.size() ) );
+      m_bytes += text;
+    }
+    void put( const sc_core::sc_time& time ) { put( uint64_t( time.value() ) ); }
+    template<typename T>
+    void put( const std::vector<T>& values )
+    {
+      put( uint64_t( values.size() ) );
+      for( const auto& value : values ) put( value );
+    }
+    template<typename T>
+    void put( const Burst<T>& burst )
+    {
+      put( uint64_t( burst.size() ) );
+      for( const auto& sample : burst ) put( sample );
+      put( burst.start() );
+      put( burst.period() );
+    }
+    const std::string& bytes() const { return m_bytes; }
+  private:
+    std::string m_bytes;
+  };
+
+  class Reader
+  {
+  public:
+    explicit Reader( const std::string& bytes ) : m_next( bytes.data() ), m_end( bytes.data() + bytes.size() ) {}
+    template<typename T>
+    void get( T& value )
+    {
+      if constexpr( std::is_trivially_copyable_v<T> ) {
+        if( not take( sizeof( T ) ) ) return;
+        std::memcpy( &value, m_next - sizeof( T ), sizeof( T ) );
+      } else {
+        if( not take( Payload<T>::bytes ) ) return;
+        Payload<T>::load( reinterpret_cast<const unsigned char*>( m_next - Payload<T>::bytes ), value );
+      }
+    }
+    void get( std::string& text )
+    {
+      uint64_t size{ 0 };
+      get( size );
+      if( not take( size ) ) return;
+      text.assign( m_next - size, size );
+    }
+    void get( sc_core::sc_time& time )
+    {
+      uint64_t value{ 0 };
+      get( value );
+      time = sc_core::sc_time::from_value( value );
+    }
+    template<typename T>
+    void get( std::vector<T>& values )
+    {
+      uint64_t size{ 0 };
+      get( size );
+      if( size > uint64_t( m_end - m_next ) ) { m_ok = false; return; }
+      values.resize( size );
+      for( auto& value : values ) get( value );
+    }
+    template<typename T>
+    void get( Burst<T>& burst )
+    {
+      std::vector<T> samples;
+      sc_core::sc_time start, period;
+      get( samples );
+      get( start );
+      get( period );
+      burst = Burst<T>{ samples.size() };
+      burst.set_timing( start, period );
+      for( const auto& sample : samples ) burst.push_back( sample );
+    }
+    bool ok() const { return m_ok; }
+    bool done() const { return m_ok and m_next == m_end; } ///< Everything consumed
+  private:
+    bool take( uint64_t size )
+    {
+      if( not m_ok or size > uint64_t( m_end - m_next ) ) return m_ok = false;
+      m_next += size;
+      return true;
+    }
+    const char* m_next;
+    const char* m_end;
+    bool        m_ok{ true };
+  };
+
+  using Save = std::function<void( Writer& )>;
+  using Load = std::function<void( Reader& )>;
+
+  // Register a section named after owner (or a plain name)
+  static void add( const sc_core::sc_object* owner, Save save, Load load )
+  {
+    add( std::string( owner->name() ), std::move( save ), std::move( load ) );
+  }
+  static void add( const std::string& name, Save save, Load load )
+  {
+    sc_assert( sections().count( name ) == 0 );
+    sections().emplace( name, Section{ std::move( save ), std::move( load ) } );
+  }
+
+  // True once, at the first quiet point past -checkpoint-at or -checkpoint-after
+  static bool due( uint64_t samples )
+  {
+    if( s_taken ) return false;
+    static const bool  by_time    = Commandline::has( "-checkpoint-at" );
+    static const bool  by_samples = Commandline::has( "-checkpoint-after" );
+    static const auto  at         = Commandline::get<sc_core::sc_time>( "-checkpoint-at", sc_core::SC_ZERO_TIME );
+    static const auto  after      = Commandline::get<uint64_t>( "-checkpoint-after", 0 );
+    return ( by_time and sc_core::sc_time_stamp() >= at ) or ( by_samples and samples >= after );
+  }
+
+  // Writes every section to -checkpoint=FILE
+  static void save( uint64_t samples )
+  {
+    s_taken = true;
+    auto filename = Commandline::get<std::string>( "-checkpoint", "checkpoint.bin" );
+    Writer out;
+    out.put( magic );
+    out.put( sc_core::sc_time_stamp() );
+    out.put( sc_core::sc_get_time_resolution().to_seconds() );
+    out.put( samples );
+    out.put( uint64_t( sections().size() ) );
+    for( const auto& [ name, section ] : sections() ) {
+      Writer payload;
+      section.save( payload );
+      out.put( name );
+      out.put( payload.bytes() );
+    }
+    std::ofstream os{ filename, std::ios::binary };
+    os.write( out.bytes().data(), std::streamsize( out.bytes().size() ) );
+    if( not os ) {
+      REPORT( ERROR, "Unable to write checkpoint " << filename );
+      return;
+    }
+    INFO( NONE, "Checkpoint after " << samples << " samples written to " << filename );
+  }
+
+  // True if -restore was given
+  static bool restoring() { return Commandline::has( "-restore" ); }
+
+  // Loads every section from -restore=FILE; call after elaboration
+  static void restore()
+  {
+    auto filename = Commandline::get<std::string>( "-restore", "checkpoint.bin" );
+    std::ifstream is{ filename, std::ios::binary };
+    std::string bytes{ std::istreambuf_iterator<char>( is ), std::istreambuf_iterator<char>() };
+    Reader in{ bytes };
+    uint64_t tag{ 0 }, samples{ 0 }, count{ 0 };
+    double resolution{ 0 };
+    in.get( tag );
+    in.get( s_time );
+    in.get( resolution );
+    in.get( samples );
+    in.get( count );
+    if( not in.ok() or tag != magic ) {
+      REPORT( ERROR, "Unable to read checkpoint " << filename );
+      return;
+    }
+    if( resolution != sc_core::sc_get_time_resolution().to_seconds() ) {
+      REPORT( ERROR, "Checkpoint " << filename << " was saved with a different time resolution" );
+      return;
+    }
+    std::map<std::string,std::string> saved;
+    for( uint64_t i = 0; i != count and in.ok(); ++i ) {
+      std::string name, payload;
+      in.get( name );
+      in.get( payload );
+      saved[ name ] = std::move( payload );
+    }
+    if( not in.done() ) {
+      REPORT( ERROR, "Checkpoint " << filename << " is truncated or damaged" );
+      return;
+    }
+    for( const auto& [ name, section ] : sections() ) {
+      auto elt = saved.find( name );
+      if( elt == saved.end() ) {
+        REPORT( WARNING, "Checkpoint " << filename << " has no state for " << name );
+        continue;
+      }
+      Reader payload{ elt->second };
+      section.load( payload );
+      if( not payload.done() ) {
+        REPORT( ERROR, "Checkpoint state for " << name << " does not match this configuration" );
+      }
+      saved.erase( elt );
+    }
+    for( const auto& [ name, payload ] : saved ) {
+      REPORT( WARNING, "Checkpoint state for " << name << " was not restored (no such instance)" );
+    }
+    INFO( NONE, "Restored " << filename << " taken at " << s_time << " after " << samples << " samples" );
+  }
+
+  // Time at which the restored checkpoint was taken
+  static sc_core::sc_time time() { return s_time; }
+
+private:
+  struct Section {
+    Save save;
+    Load load;
+  };
+  static std::map<std::string,Section>& sections() ///< Ordered, so files are stable
+  {
+    static std::map<std::string,Section> result;
+    return result;
+  }
+  static constexpr uint64_t magic{ 0x31304B4348435344u }; ///< "DSCHCK01"
+  static constexpr const char* const MSGID{ "/Doulos/Example/checkpoint" };
+  inline static const bool described
+  { Commandline::describe( "-checkpoint=FILE", "Writes the checkpoint to FILE (default checkpoint.bin)" )
+    and Commandline::describe( "-checkpoint-at=TIME", "Saves a checkpoint at the first sample boundary from TIME" )
+    and Commandline::describe( "-checkpoint-after=SAMPLES", "Saves a checkpoint once SAMPLES samples have been sent" )
+    and Commandline::describe( "-restore=FILE", "Resumes from a checkpoint saved by an identical build and options" ) };
+  inline static bool             s_taken{ false };
+  inline static sc_core::sc_time s_time{ sc_core::SC_ZERO_TIME };
+};
+
+// TAF!
@@ -1,20 +1,248 @@
 #pragma once
 
+/** @class Commandline
+
+@brief Parse-once registry of command-line options
+
+The command-line is tokenized once, on first use, into a table indexed by
+option name. An option is either `-name` or `-name=value`, and may be
+repeated. Typed getters convert values on request:
+
+```c++
+auto samples = Commandline::get<int>( "-n", 10 );        // last one wins
+auto quantum = Commandline::get<sc_time>( "-quantum", 100_ns );
+for( const auto& inst : Commandline::get_all<std::string>( "-debug" ) ) ...
+```
+
+Values that cannot be converted are reported as errors and replaced by the
+default. Read options in constructors so that problems surface during
+elaboration rather than in the middle of a simulation.
+
+Options are described for the help text where they are used:
+
+```c++
+namespace {
+  [[maybe_unused]] const bool described
+  { Commandline::describe( "-n=SAMPLE_SIZE", "Number of samples to generate (default 10)" ) };
+}
+```
+
+********************************************************************************
+*/
+
 #include "systemc.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 struct Commandline
 {
+  // Add an entry (e.g. "-n=SAMPLE_SIZE") to the help text. Returns true so
+  // it may be used to initialize a file-local variable.
+  static bool describe( const std::string& usage, const std::string& text )
+  {
+    descriptions().emplace_back( usage, text );
+    return true;
+  }
+
   // Return index if a command-line argument beginning with opt exists; otherwise, zero
-  inline static size_t has_opt( std::string opt )
+  inline static size_t has_opt( const std::string& opt )
   {
-    for( int i = 1; i < sc_core::sc_argc(); ++i ) {
-      std::string arg{ sc_core::sc_argv()[ i ] };
-      if( arg.find( opt ) == 0 ) return i;
+    const auto& args{ table().args };
+    for( size_t i = 0; i < args.size(); ++i ) {
+      if( args[ i ].text.compare( 0, opt.size(), opt ) == 0 ) return i + 1;
     }
     return 0;
   }
+
+  // Return true if option name (e.g. "-n") was specified with or without a value
+  static bool has( const std::string& name )
+  {
+    return table().index.count( name ) != 0;
+  }
+
+  // Return value of the last occurrence of name, or dflt if absent or valueless
+  template<typename T>
+  static T get( const std::string& name, T dflt )
+  {
+    const auto& tbl{ table() };
+    auto elt = tbl.index.find( name );
+    if( elt == tbl.index.end() ) return dflt;
+    const auto& arg{ tbl.args[ elt->second.back() ] };
+    if( not arg.has_value ) return dflt;
+    T result{ dflt };
+    if( not convert( arg.value, result ) ) {
+      bad_value( arg.text );
+      return dflt;
+    }
+    return result;
+  }
+
+  // Return the values of every occurrence of name that has a value
+  template<typename T>
+  static std::vector<T> get_all( const std::string& name )
+  {
+    std::vector<T> result;
+    const auto& tbl{ table() };
+    auto elt = tbl.index.find( name );
+    if( elt == tbl.index.end() ) return result;
+    for( auto i : elt->second ) {
+      const auto& arg{ tbl.args[ i ] };
+      if( not arg.has_value ) continue;
+      T value{};
+      if( convert( arg.value, value ) ) result.push_back( value );
+      else                              bad_value( arg.text );
+    }
+    return result;
+  }
+
+  // Add an option (e.g. "-seed=5") after those on the command-line, so it
+  // wins over earlier occurrences. Used by regression workers.
+  static void append( const std::string& text )
+  {
+    add( table(), text );
+  }
+
+  // Warn about options that were never described
+  static void check()
+  {
+    const auto& tbl{ table() };
+    for( const auto& arg : tbl.args ) {
+      auto known = std::any_of( descriptions().begin(), descriptions().end()
+                              , [&arg]( const auto& desc ) {
+                                  return option_name( desc.first ) == arg.name;
+                                } );
+      if( not known ) {
+        std::string note{ "Unknown command-line option " };
+        note += arg.text;
+        SC_REPORT_WARNING( MSGID, note.c_str() );
+      }
+    }
+  }
+
+  // Display a table of the described options
+  static void help( std::ostream& os )
+  {
+    auto descs{ descriptions() };
+    std::sort( descs.begin(), descs.end() );
+    size_t usage_width = 6, text_width = 11;
+    for( const auto& [ usage, text ] : descs ) {
+      usage_width = std::max( usage_width, usage.size() );
+      text_width  = std::max( text_width,  text.size() );
+    }
+    os << std::left
+       << "| " << std::setw( usage_width ) << "Option" << " | " << std::setw( text_width ) << "Description" << " |\n"
+       << "| :" << std::string( usage_width - 1, '-' ) << " | :" << std::string( text_width - 1, '-' ) << " |\n";
+    for( const auto& [ usage, text ] : descs ) {
+      os << "| " << std::setw( usage_width ) << usage << " | " << std::setw( text_width ) << text << " |\n";
+    }
+    os << std::right;
+  }
+
 private:
-  [[maybe_unused]]inline constexpr static char const * const
+  struct Arg {
+    std::string text;  // as given
+    std::string name;  // up to '='
+    std::string value; // after '='
+    bool        has_value{ false };
+  };
+  struct Table {
+    std::vector<Arg>                                     args;
+    std::unordered_map<std::string,std::vector<size_t>>  index; // name -> args
+  };
+  static Table& table()
+  {
+    static Table tbl{ [] {
+      Table t;
+      for( int i = 1; i < sc_core::sc_argc(); ++i ) {
+        add( t, sc_core::sc_argv()[ i ] );
+      }
+      return t;
+    }() };
+    return tbl;
+  }
+  static void add( Table& t, const std::string& text )
+  {
+    Arg arg;
+    arg.text = text;
+    auto pos = arg.text.find( '=' );
+    arg.name = arg.text.substr( 0, pos );
+    if( pos != std::string::npos ) {
+      arg.value = arg.text.substr( pos + 1 );
+      arg.has_value = true;
+    }
+    t.index[ arg.name ].push_back( t.args.size() );
+    t.args.push_back( std::move( arg ) );
+  }
+  static std::vector<std::pair<std::string,std::string>>& descriptions()
+  {
+    static std::vector<std::pair<std::string,std::string>> descs;
+    return descs;
+  }
+  static std::string option_name( const std::string& usage )
+  {
+    return usage.substr( 0, usage.find( '=' ) );
+  }
+  static void bad_value( const std::string& text )
+  {
+    std::string note{ "Unable to interpret command-line option " };
+    note += text;
+    SC_REPORT_ERROR( MSGID, note.c_str() );
+  }
+  // Conversions return false if the text was not completely consumed
+  static bool convert( const std::string& text, std::string& result )
+  {
+    result = text;
+    return true;
+  }
+  static bool convert( const std::string& text, double& result )
+  {
+    char* end{ nullptr };
+    result = std::strtod( text.c_str(), &end );
+    return not text.empty() and *end == '\0';
+  }
+  template<typename T>
+  static std::enable_if_t<std::is_integral_v<T>,bool>
+  convert( const std::string& text, T& result )
+  {
+    char* end{ nullptr };
+    if constexpr( std::is_signed_v<T> ) {
+      result = static_cast<T>( std::strtoll( text.c_str(), &end, 0 ) );
+    } else {
+      // strtoull() would quietly wrap -1 to the largest value
+      auto first = text.find_first_not_of( " \t" );
+      if( first != std::string::npos and text[ first ] == '-' ) return false;
+      result = static_cast<T>( std::strtoull( text.c_str(), &end, 0 ) );
+    }
+    return not text.empty() and *end == '\0';
+  }
+  // Accepts 100_ns, 100ns, and 100 ns
+  static bool convert( const std::string& text, sc_core::sc_time& result )
+  {
+    using namespace sc_core;
+    static const std::pair<const char*,sc_time_unit> units[] {
+      { "fs", SC_FS }, { "ps", SC_PS }, { "ns", SC_NS },
+      { "us", SC_US }, { "ms", SC_MS }, { "sec", SC_SEC }, { "s", SC_SEC },
+    };
+    char* end{ nullptr };
+    double magnitude = std::strtod( text.c_str(), &end );
+    if( end == text.c_str() ) return false;
+    std::string unit{ end };
+    unit.erase( 0, unit.find_first_not_of( " _" ) );
+    for( const auto& [ suffix, tu ] : units ) {
+      if( unit == suffix ) {
+        result = sc_time( magnitude, tu );
+        return true;
+      }
+    }
+    return false;
+  }
+  inline constexpr static char const * const
   MSGID{ "/Doulos/Example/Commandline" };
 };
@@ -3,5 +3,5 @@
 #include <cstdint>
 #include "sc_time_literal.hpp"
 #include "report.hpp"
+#include "data_type.hpp"
 using namespace std::literals;
-using Data_t = uint16_t;
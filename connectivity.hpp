@@ -0,0 +1,90 @@
+#pragma once
+
+/** @class Connectivity
+
+@brief Index from channel interfaces to the ports and exports bound to them
+
+Built once, in a single pass over the object hierarchy, the first time it is
+used. Lookups are then constant time, so any number of modules can ask
+whether their channels are connected without walking the hierarchy.
+
+`make scale` is the elaboration benchmark for the index: at 10,000 lanes
+(`-lanes`), tens of thousands of modules are elaborated and 10,000
+splitters query it, and the elaboration_s column of scale.csv shows how
+elaboration time grows with the number of modules.
+
+Ports and exports resolve to the channel interface at the end of their
+binding, so the index is only valid from `end_of_elaboration()` onwards.
+Only the first interface of a multiport is indexed.
+
+Usage
+-----
+
+```c++
+void My_module::end_of_elaboration()
+{
+  if( not Connectivity::get().is_connected( &channel ) ) ...
+}
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include <unordered_map>
+#include <vector>
+
+class Connectivity
+{
+public:
+  static const Connectivity& get() ///< Index, built on first use
+  {
+    sc_assert( sc_core::sc_get_status() >= sc_core::SC_END_OF_ELABORATION );
+    static const Connectivity index{};
+    return index;
+  }
+  bool is_connected( const sc_core::sc_interface* chan_if ) const ///< Any port bound
+  {
+    return not ports( chan_if ).empty();
+  }
+  const std::vector<sc_core::sc_port_base*>& ports( const sc_core::sc_interface* chan_if ) const
+  {
+    auto elt = m_index.find( chan_if );
+    return elt == m_index.end() ? s_none.ports : elt->second.ports;
+  }
+  const std::vector<sc_core::sc_export_base*>& exports( const sc_core::sc_interface* chan_if ) const
+  {
+    auto elt = m_index.find( chan_if );
+    return elt == m_index.end() ? s_none.exports : elt->second.exports;
+  }
+  size_t objects() const { return m_objects; } ///< Objects visited when built
+
+private:
+  struct Bindings {
+    std::vector<sc_core::sc_port_base*>   ports;
+    std::vector<sc_core::sc_export_base*> exports;
+  };
+  Connectivity()
+  {
+    for( auto obj : sc_core::sc_get_top_level_objects() ) add( obj );
+  }
+  void add( sc_core::sc_object* obj )
+  {
+    ++m_objects;
+    if( auto port = dynamic_cast<sc_core::sc_port_base*>( obj ); port != nullptr ) {
+      if( auto chan_if = port->get_interface(); chan_if != nullptr ) {
+        m_index[ chan_if ].ports.push_back( port );
+      }
+    } else if( auto xport = dynamic_cast<sc_core::sc_export_base*>( obj ); xport != nullptr ) {
+      if( auto chan_if = xport->get_interface(); chan_if != nullptr ) {
+        m_index[ chan_if ].exports.push_back( xport );
+      }
+    }
+    for( auto child : obj->get_child_objects() ) add( child );
+  }
+  std::unordered_map<const sc_core::sc_interface*, Bindings> m_index;
+  size_t m_objects{ 0 };
+  inline static const Bindings s_none{};
+};
+
+// TAF!
@@ -0,0 +1,6 @@
+#pragma once
+
+// Sample type of the pipeline; free of SystemC so that the reference model
+// and its standalone test can share it
+#include <cstdint>
+using Data_t = uint16_t;
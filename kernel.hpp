@@ -0,0 +1,180 @@
+#pragma once
+
+/** @class Kernel
+
+@brief Compile-time policies describing a behavior datapath
+
+A kernel combines three policies:
+
+- a *transform* (`transform( value )` and a batch `transform( in, out, n )`),
+- a *latency* model (`read_delay()` before the input is sampled and
+  `process_delay()` before the result is written),
+- an *error injection* model (`inject_bit<T>( rng, weight )` returns the
+  bit to flip, or -1, drawing from the behavior's own `Random` stream).
+
+Transforms and injection are templates on the payload type `T`, using
+`Payload<T>` for anything that depends on its width (see payload.hpp).
+
+`Behavior_module<T,Kernel>` is instantiated for each kernel in
+`Kernel_registry::List`, so the policies are inlined into its processes.
+`-kernel=NAME` selects one at run time, and the observer derives its
+expectations from the same kernel through `Kernel_registry::info<T>()`.
+
+Adding a kernel
+---------------
+
+```c++
+struct My_kernel : Kernel<My_transform, Default_latency, No_injection>
+{
+  static constexpr const char* name{ "mine" };
+};
+```
+
+then add it to `Kernel_registry::List`.
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "common.hpp"
+#include "commandline.hpp"
+#include "reference_model.hpp"
+#include "random.hpp"
+#include "payload.hpp"
+#include <string>
+#include <tuple>
+
+//------------------------------------------------------------------------------
+// Transform policies
+struct Invert_transform ///< Reference model
+{
+  template<typename T>
+  static T transform( const T& value )
+  {
+    if constexpr( std::is_same_v<T,Data_t> ) return Reference_model::transform( value );
+    else return Payload<T>::invert( value );
+  }
+  template<typename T>
+  static void transform( const T* in, T* out, size_t n )
+  {
+    if constexpr( std::is_same_v<T,Data_t> ) Reference_model::transform( in, out, n );
+    else for( size_t i = 0; i != n; ++i ) out[ i ] = Payload<T>::invert( in[ i ] );
+  }
+};
+
+struct Swap_transform ///< Swaps halves (bytes of a 16-bit payload)
+{
+  template<typename T>
+  static T transform( const T& value ) { return Payload<T>::rotate( value, Payload<T>::width / 2 ); }
+  template<typename T>
+  static void transform( const T* in, T* out, size_t n )
+  {
+    for( size_t i = 0; i != n; ++i ) out[ i ] = transform( in[ i ] ); // Vectorized by the compiler
+  }
+};
+
+//------------------------------------------------------------------------------
+// Latency policies
+struct Default_latency
+{
+  static sc_core::sc_time read_delay() { return 2.5_ns; }
+  static sc_core::sc_time process_delay() { return 2.5_ns; }
+};
+
+struct Short_latency
+{
+  static sc_core::sc_time read_delay() { return 0.5_ns; }
+  static sc_core::sc_time process_delay() { return 0.5_ns; }
+};
+
+//------------------------------------------------------------------------------
+// Error injection policies
+struct Random_bit_injection ///< Flips one random bit in weight percent of results
+{
+  static constexpr bool injects{ true };
+  template<typename T>
+  static int inject_bit( Random& rng, int weight )
+  {
+    return rng.percent( weight ) ? int( rng.below( Payload<T>::width ) ) : -1;
+  }
+};
+
+struct No_injection
+{
+  static constexpr bool injects{ false };
+  template<typename T>
+  static int inject_bit( Random&, int ) { return -1; }
+};
+
+//------------------------------------------------------------------------------
+template<typename Transform, typename Latency, typename Injection>
+struct Kernel : Transform, Latency, Injection
+{
+  static sc_core::sc_time latency() { return Latency::read_delay() + Latency::process_delay(); }
+};
+
+struct Invert_kernel : Kernel<Invert_transform, Default_latency, Random_bit_injection>
+{
+  static constexpr const char* name{ "invert" };
+};
+
+struct Swap_kernel : Kernel<Swap_transform, Default_latency, Random_bit_injection>
+{
+  static constexpr const char* name{ "swap" };
+};
+
+struct Fast_kernel : Kernel<Invert_transform, Short_latency, No_injection>
+{
+  static constexpr const char* name{ "fast" };
+};
+
+//------------------------------------------------------------------------------
+// Type-erased view used outside the behavior (e.g. by the observer)
+template<typename T>
+struct Kernel_info
+{
+  const char* name;
+  T    (*transform)( const T& );
+  void (*batch)( const T*, T*, size_t );
+};
+
+struct Kernel_registry
+{
+  using List    = std::tuple<Invert_kernel, Swap_kernel, Fast_kernel>;
+  using Default = std::tuple_element_t<0,List>;
+  template<typename F>
+  static void for_each( F&& f ) ///< Calls f( kernel ) for each kernel type
+  {
+    std::apply( [&]( auto... kernel ){ ( f( kernel ), ... ); }, List{} );
+  }
+  static std::string selected() ///< Name given by -kernel, if known
+  {
+    auto name = Commandline::get<std::string>( "-kernel", Default::name );
+    bool known = false;
+    for_each( [&]( auto kernel ){ known = known or name == kernel.name; } );
+    if( not known ) {
+      REPORT( ERROR, "Unknown kernel " << name << "; using " << Default::name );
+      name = Default::name;
+    }
+    return name;
+  }
+  template<typename T>
+  static Kernel_info<T> info( const std::string& name )
+  {
+    Kernel_info<T> result{};
+    for_each( [&]( auto kernel ){
+      using K = decltype( kernel );
+      if( name == K::name ) {
+        result = { K::name, &K::template transform<T>, &K::template transform<T> };
+      }
+    } );
+    sc_assert( result.name != nullptr );
+    return result;
+  }
+private:
+  static constexpr const char* const MSGID{ "/Doulos/Example/kernel" };
+  inline static const bool described
+  { Commandline::describe( "-kernel=NAME", "Behavior kernel NAME: invert (default), swap or fast" ) };
+};
+
+// TAF!
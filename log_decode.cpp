@@ -0,0 +1,77 @@
+// Offline decoder for binary logs written by Log_sink (see log_sink.hpp)
+//
+// Usage: log_decode.x FILE.sclog > FILE.log
+//
+// Does not require SystemC.
+
+#include "log_record.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+  const char* const severities[]{ "Info", "Warning", "Error", "Fatal" };
+
+  // Same text as sc_time::to_string()
+  std::string time_text( uint64_t val, uint64_t resolution_fs )
+  {
+    static const char* const units[]{ "fs", "ps", "ns", "us", "ms", "s" };
+    if( val == 0 ) return "0 s";
+    int n = 0;
+    for( auto tr = resolution_fs; tr > 0 and tr % 10 == 0; tr /= 10 ) ++n;
+    while( val % 10 == 0 ) { val /= 10; ++n; }
+    auto result = std::to_string( val );
+    if( n >= 15 ) {
+      result += std::string( n - 15, '0' ) + " s";
+    } else {
+      result += std::string( n % 3, '0' ) + " " + units[ n / 3 ];
+    }
+    return result;
+  }
+
+}
+
+int main( int argc, char* argv[] )
+{
+  if( argc != 2 ) {
+    std::fprintf( stderr, "Usage: %s FILE\n", argv[ 0 ] );
+    return 2;
+  }
+  auto fp = std::fopen( argv[ 1 ], "rb" );
+  if( fp == nullptr ) {
+    std::perror( argv[ 1 ] );
+    return 1;
+  }
+  Log_format::File_header header{};
+  if( std::fread( &header, sizeof( header ), 1, fp ) != 1
+   or std::memcmp( header.magic, Log_format::magic, sizeof( header.magic ) ) != 0 ) {
+    std::fprintf( stderr, "Error: %s is not a log written by Log_sink\n", argv[ 1 ] );
+    return 1;
+  }
+  std::vector<std::string> msg_types;
+  std::string text;
+  Log_format::Record_header record{};
+  while( std::fread( &record, sizeof( record ), 1, fp ) == 1 ) {
+    text.resize( record.length );
+    if( record.length != 0 and std::fread( text.data(), record.length, 1, fp ) != 1 ) {
+      std::fprintf( stderr, "Warning: %s is truncated\n", argv[ 1 ] );
+      break;
+    }
+    if( record.kind == Log_format::msg_type ) {
+      if( msg_types.size() <= record.id ) msg_types.resize( record.id + 1 );
+      msg_types[ record.id ] = text;
+      continue;
+    }
+    const char* severity = record.severity < 4 ? severities[ record.severity ] : "Unknown";
+    const char* msg_type = record.id < msg_types.size() ? msg_types[ record.id ].c_str() : "?";
+    std::printf( "@%s %s: %s: %s\n"
+               , time_text( record.time, header.resolution_fs ).c_str()
+               , severity, msg_type, text.c_str() );
+  }
+  std::fclose( fp );
+  return 0;
+}
+
+// TAF!
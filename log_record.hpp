@@ -0,0 +1,47 @@
+#pragma once
+
+/** @file log_record.hpp
+
+@brief Binary layout of files written by Log_sink
+
+Shared by the simulator (log_sink.cpp) and the offline decoder
+(log_decode.cpp), so this header must not depend on SystemC.
+
+A file is a File_header followed by a sequence of records. Each record is
+a Record_header followed by `length` bytes of text (not NUL terminated).
+Message types (e.g. "/Doulos/Example/tracing") are written once, as a
+`msg_type` record, the first time they are seen; `message` records refer
+to them by id.
+
+********************************************************************************
+*/
+
+#include <cstdint>
+
+namespace Log_format {
+
+  constexpr char magic[ 8 ]{ 'S', 'C', 'L', 'O', 'G', '0', '1', '\0' };
+
+  struct File_header {
+    char     magic[ 8 ];
+    uint64_t resolution_fs;  ///< Femtoseconds per time tick
+  };
+
+  enum Kind : uint8_t { message = 1, msg_type = 2 };
+
+  struct Record_header {
+    uint64_t time;      ///< Simulation time in ticks
+    uint32_t id;        ///< Message type index
+    int32_t  verbosity;
+    uint16_t length;    ///< Bytes of text that follow
+    uint8_t  kind;
+    uint8_t  severity;  ///< sc_core::sc_severity
+    uint32_t reserved;
+  };
+
+  static_assert( sizeof( File_header ) == 16 );
+  static_assert( sizeof( Record_header ) == 24 );
+
+}
+
+// TAF!
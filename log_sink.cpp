@@ -0,0 +1,147 @@
+#include "log_sink.hpp"
+#include "log_record.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace sc_core;
+
+Log_sink::Log_sink( std::FILE* fp )
+: m_fp( fp )
+{
+  Log_format::File_header header{};
+  std::memcpy( header.magic, Log_format::magic, sizeof( header.magic ) );
+  header.resolution_fs = static_cast<uint64_t>( sc_get_time_resolution().to_seconds() * 1e15 + 0.5 );
+  std::fwrite( &header, sizeof( header ), 1, m_fp );
+  m_writer = std::thread( &Log_sink::writer, this );
+}
+
+Log_sink::~Log_sink()
+{
+  m_stop.store( true, std::memory_order_release );
+  m_writer.join();
+  std::fclose( m_fp );
+}
+
+void Log_sink::open( const std::string& filename )
+{
+  sc_assert( s_sink == nullptr );
+  auto fp = std::fopen( filename.c_str(), "wb" );
+  if( fp == nullptr ) {
+    std::string note{ "Unable to open log file " };
+    note += filename;
+    SC_REPORT_ERROR( MSGID, note.c_str() );
+    return;
+  }
+  s_sink.reset( new Log_sink( fp ) );
+  sc_report_handler::set_handler( &Log_sink::handler );
+}
+
+void Log_sink::flush()
+{
+  if( s_sink == nullptr ) return;
+  auto target = s_sink->m_head.load( std::memory_order_relaxed );
+  while( s_sink->m_flushed.load( std::memory_order_acquire ) < target ) {
+    std::this_thread::yield();
+  }
+}
+
+void Log_sink::close()
+{
+  if( s_sink == nullptr ) return;
+  sc_report_handler::set_handler( &sc_report_handler::default_handler );
+  s_sink.reset(); // Drains and joins
+}
+
+void Log_sink::handler( const sc_report& rep, const sc_actions& actions )
+{
+  constexpr sc_actions diverted = SC_DISPLAY | SC_LOG;
+  auto remaining = actions;
+  if( ( actions & diverted ) != 0 and s_sink != nullptr ) {
+    s_sink->push( rep );
+    // Errors and fatals are rare enough to display as well
+    if( rep.get_severity() < SC_ERROR ) remaining &= ~diverted;
+  }
+  if( ( remaining & ( SC_THROW | SC_STOP | SC_ABORT | SC_INTERRUPT ) ) != 0 ) {
+    flush();
+  }
+  sc_report_handler::default_handler( rep, remaining );
+}
+
+void Log_sink::push( const sc_report& rep )
+{
+  Log_format::Record_header header{};
+  header.id        = intern( rep.get_msg_type() );
+  auto msg         = rep.get_msg();
+  auto length      = std::min<size_t>( std::strlen( msg ), UINT16_MAX );
+  header.time      = rep.get_time().value();
+  header.verbosity = rep.get_verbosity();
+  header.length    = static_cast<uint16_t>( length );
+  header.kind      = Log_format::message;
+  header.severity  = static_cast<uint8_t>( rep.get_severity() );
+  put( &header, sizeof( header ) );
+  put( msg, length );
+}
+
+// Message types are written the first time they are seen
+uint32_t Log_sink::intern( const char* msg_type )
+{
+  if( auto elt = m_ids.find( msg_type ); elt != m_ids.end() ) return elt->second;
+  auto id = static_cast<uint32_t>( m_names.size() );
+  const auto& name = m_names.emplace_back( msg_type );
+  m_ids.emplace( name, id );
+  Log_format::Record_header header{};
+  header.id     = id;
+  header.length = static_cast<uint16_t>( std::min<size_t>( name.size(), UINT16_MAX ) );
+  header.kind   = Log_format::msg_type;
+  put( &header, sizeof( header ) );
+  put( name.data(), header.length );
+  return id;
+}
+
+// Producer side: copy bytes into the ring, waiting for room if necessary
+void Log_sink::put( const void* data, size_t size )
+{
+  auto bytes = static_cast<const char*>( data );
+  auto head  = m_head.load( std::memory_order_relaxed );
+  while( size > 0 ) {
+    auto room = capacity - ( head - m_tail.load( std::memory_order_acquire ) );
+    if( room == 0 ) {
+      std::this_thread::yield();
+      continue;
+    }
+    auto offset = head & ( capacity - 1 );
+    auto chunk  = std::min( { size, room, capacity - offset } );
+    std::memcpy( &m_ring[ offset ], bytes, chunk );
+    bytes += chunk;
+    size  -= chunk;
+    head  += chunk;
+    m_head.store( head, std::memory_order_release );
+  }
+}
+
+// Consumer side: runs on its own thread
+void Log_sink::writer()
+{
+  auto tail = m_tail.load( std::memory_order_relaxed );
+  for(;;) {
+    auto stopping = m_stop.load( std::memory_order_acquire );
+    auto head     = m_head.load( std::memory_order_acquire );
+    if( head != tail ) {
+      while( tail != head ) {
+        auto offset = tail & ( capacity - 1 );
+        auto chunk  = std::min( head - tail, capacity - offset );
+        std::fwrite( &m_ring[ offset ], 1, chunk, m_fp );
+        tail += chunk;
+      }
+      m_tail.store( tail, std::memory_order_release );
+      continue;
+    }
+    std::fflush( m_fp );
+    m_flushed.store( tail, std::memory_order_release );
+    if( stopping ) break;
+    std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+  }
+}
+
+// TAF!
@@ -0,0 +1,69 @@
+#pragma once
+
+/** @class Log_sink
+
+@brief Asynchronous binary log for reports
+
+When opened, Log_sink installs an sc_report_handler handler that converts
+each displayed or logged report into a compact binary record (time,
+severity, message type index, text) and pushes it into a lock-free
+single-producer/single-consumer ring buffer. A background thread drains
+the ring to the file, so the simulation never waits on formatting or on
+terminal output. Use log_decode.x to convert the file into text.
+
+Errors and fatals are also displayed as usual. Reports that stop, abort,
+interrupt or throw flush the log before the default action is taken, and
+close() (or the end of the program) drains everything that remains, so
+no messages are lost.
+
+Usage
+-----
+
+```c++
+Log_sink::open( "run.sclog" );
+...simulate...
+Log_sink::close();
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+struct Log_sink
+{
+  static void open( const std::string& filename ); ///< Start logging to filename
+  static void flush();                             ///< Wait until everything is on disk
+  static void close();                             ///< Flush, stop and restore default handler
+  static bool is_open() { return s_sink != nullptr; }
+  ~Log_sink();
+private:
+  explicit Log_sink( std::FILE* fp );
+  static void handler( const sc_core::sc_report& rep, const sc_core::sc_actions& actions );
+  void push( const sc_core::sc_report& rep );
+  void put( const void* data, size_t size );
+  uint32_t intern( const char* msg_type );
+  void writer();
+  static constexpr size_t capacity{ size_t{ 1 } << 20 }; // bytes, power of two
+  std::unique_ptr<char[]> m_ring{ new char[ capacity ] };
+  std::atomic<uint64_t>   m_head{ 0 };    ///< Bytes produced (simulation side)
+  std::atomic<uint64_t>   m_tail{ 0 };    ///< Bytes consumed (writer side)
+  std::atomic<uint64_t>   m_flushed{ 0 }; ///< Bytes on disk
+  std::atomic<bool>       m_stop{ false };
+  std::FILE*              m_fp;
+  std::deque<std::string> m_names;        ///< Storage for interned message types
+  std::unordered_map<std::string_view,uint32_t> m_ids;
+  std::thread             m_writer;
+  static constexpr const char* const MSGID{ "/Doulos/Example/Log_sink" };
+  inline static std::unique_ptr<Log_sink> s_sink;
+};
+
+//TAF!
@@ -5,19 +5,73 @@
 #include <iomanip>
 #include "top.hpp"
 #include "commandline.hpp"
+#include "log_sink.hpp"
+#include "objection.hpp"
+#include "regression.hpp"
+#include "microbench.hpp"
+#include "metrics.hpp"
+#include "profile.hpp"
+#include "checkpoint.hpp"
 using namespace sc_core;
 
 // Every file needs the following with appropriate adjustments
 namespace {
   constexpr char const* const MSGID{ "/Doulos/Example/tracing/main" };
+  [[maybe_unused]] const bool described
+  { Commandline::describe( "-help", "Displays this text and exits" ) };
+
+  // Elaborate, simulate and summarize; returns the exit status
+  int simulate()
+  {
+    Metrics metrics;
+    SC_REPORT_INFO( MSGID, "Instantiating" );
+    Top_module top{"top"};
+    if( Checkpoint::restoring() ) Checkpoint::restore();
+
+    SC_REPORT_INFO( MSGID, "Starting simulator" );
+    metrics.start();
+    if( Commandline::has( "-profile" ) ) Profile::start();
+    sc_start();
+    Profile::stop();
+    metrics.stop();
+
+    // Clean up
+    if ( not sc_end_of_simulation_invoked() )
+    {
+      SC_REPORT_ERROR( MSGID, "Simulation stopped without explicit sc_stop()");
+      Objection::report_holders();
+      sc_stop(); //< invoke end_of_simulation() overrides
+    }
+    Log_sink::close(); //< Summary goes to the terminal
+
+    auto errors = sc_report_handler::get_count(SC_ERROR)
+                + sc_report_handler::get_count(SC_FATAL);
+
+    INFO( NONE, "\n" << std::string(80,'#') << "\nSummary for " << sc_argv()[0] << ":\n  "
+      << std::setw(2) << sc_report_handler::get_count(SC_INFO)    << " informational messages" << "\n  "
+      << std::setw(2) << sc_report_handler::get_count(SC_WARNING) << " warnings" << "\n  "
+      << std::setw(2) << sc_report_handler::get_count(SC_ERROR)   << " errors"   << "\n  "
+      << std::setw(2) << sc_report_handler::get_count(SC_FATAL)   << " fatals"   << "\n  "
+      << std::setw(2) << sc_delta_count()                         << " delta cycles" << "\n\n"
+      << "Simulation " << (errors?"FAILED":"PASSED")
+    );
+    Profile::report( std::cout );
+    if( auto file = Commandline::get<std::string>( "-profile", "" ); not file.empty() ) {
+      Profile::dump( file );
+    }
+    metrics.traced( Top_module::trace_filename() );
+    metrics.write();
+
+    return (errors?1:0);
+  }
 }
 
 int sc_main( [[maybe_unused]]int argc, [[maybe_unused]]char* argv[] )
 {
   // Built-in run-time help is often welcome
-  if( Commandline::has_opt( "-help" )
-   or Commandline::has_opt( "--help")
-   or Commandline::has_opt( "-h" )
+  if( Commandline::has( "-help" )
+   or Commandline::has( "--help")
+   or Commandline::has( "-h" )
   ) {
     // Example of C++11 raw strings R"( .... )"
     std::cout << R"(
@@ -26,17 +80,10 @@ int sc_main( [[maybe_unused]]int argc, [[maybe_unused]]char* argv[] )
 Run-time options:
 -----------------
 
-| Option          | Description                                  |
-| :-------------- | :------------------------------------------- |
-| -help           | Displays this text and exits                 |
-| -debug          | Increases verbosity to debug level (noisy)   |
-| -debug=INSTANCE | Debug messages for instances named INSTANCE  |
-| -debugall       | Debug messages for all instances             |
-| -inject=PERCENT | Inject errors at a range of PERCENT (1..100) |
-| -n=SAMPLE_SIZE  | Number of samples to generate (default 10)   |
-| -quiet          | Decreases verbosity lowest level             |
-| -trace          | Enables output of waveform data to dump.vcd  |
-
+)";
+    // Each option is described where it is used
+    Commandline::help( std::cout );
+    std::cout << R"(
 Note: If multiple verbosities are specified, the last one wins.
 
 --------------------------------------------------------------------------------
@@ -44,31 +91,16 @@ Note: If multiple verbosities are specified, the last one wins.
     return 0;
   }
 
-  SC_REPORT_INFO( MSGID, "Instantiating" );
-  Top_module top{"top"};
-
-  SC_REPORT_INFO( MSGID, "Starting simulator" );
-  sc_start();
-
-  // Clean up
-  if ( not sc_end_of_simulation_invoked() )
-  {
-    SC_REPORT_ERROR( MSGID, "Simulation stopped without explicit sc_stop()");
-    sc_stop(); //< invoke end_of_simulation() overrides
+  // Reporting costs instead of a simulation
+  if( Microbench::requested() ) {
+    return Microbench::run();
   }
 
-  auto errors = sc_report_handler::get_count(SC_ERROR)
-              + sc_report_handler::get_count(SC_FATAL);
-
-  INFO( NONE, "\n" << std::string(80,'#') << "\nSummary for " << sc_argv()[0] << ":\n  "
-    << std::setw(2) << sc_report_handler::get_count(SC_INFO)    << " informational messages" << "\n  "
-    << std::setw(2) << sc_report_handler::get_count(SC_WARNING) << " warnings" << "\n  "
-    << std::setw(2) << sc_report_handler::get_count(SC_ERROR)   << " errors"   << "\n  "
-    << std::setw(2) << sc_report_handler::get_count(SC_FATAL)   << " fatals"   << "\n\n"
-    << "Simulation " << (errors?"FAILED":"PASSED")
-  );
-
-  return (errors?1:0);
+  // Each seed needs its own process
+  if( Regression::requested() ) {
+    return Regression::run( simulate );
+  }
+  return simulate();
 }
 
 // TAF!
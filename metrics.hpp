@@ -0,0 +1,152 @@
+#pragma once
+
+/** @class Metrics
+
+@brief Run-time performance figures for benchmarking
+
+Measures the wall time of elaboration and of simulation, and with
+`-metrics=FILE` appends one row per run to FILE: the options used, the
+samples actually sent (each stimulus reports them through `sent()`, so
+`-stim` and a clamped `-n` count correctly), wall times, samples per
+second, the ratio of simulated time to wall time, peak resident set size,
+delta cycles, errors and the size of any trace file, and with `-profile`
+the total activations of profiled processes (otherwise 0). For scaling
+studies with `-lanes=K`, samples count every lane, and the row ends with
+K, the samples per second of each lane and the memory per lane (growth of
+the peak resident set size during elaboration, divided by K). FILE is CSV
+(with a header when new) unless its name ends in `.json`, in which case
+each run is one JSON object per line.
+
+`make bench` runs the pipeline over a matrix of options and collects the
+rows in bench.csv, running each configuration once plain (for timings)
+and once with `-profile` (for activations); `make scale` does the same
+for 1 to 10,000 lanes in scale.csv, which doubles as the benchmark of
+elaborating large designs.
+
+Usage
+-----
+
+```c++
+Metrics metrics;                  // Before elaboration
+...elaborate...
+metrics.start();                  // Just before sc_start()
+...simulate...                    // Metrics::sent( n ) as samples go out
+metrics.stop();
+metrics.traced( "dump.vcd" );     // If tracing
+metrics.write();                  // If -metrics=FILE
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "commandline.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+struct Metrics
+{
+  using Clock = std::chrono::steady_clock;
+  Metrics() : m_begin( Clock::now() ), m_start( m_begin ), m_stop( m_begin ), m_rss_begin( peak_rss_kb() ) {}
+  void start() { m_start = Clock::now(); m_rss_start = peak_rss_kb(); }
+  void stop()  { m_stop  = Clock::now(); }
+  void traced( const std::string& filename ) { m_trace_filename = filename; } ///< Waveform file written
+  static void sent( uint64_t samples ) { s_sent += samples; } ///< Called by each stimulus
+
+  void write() const
+  {
+    if( not Commandline::has( "-metrics" ) ) return;
+    auto filename = Commandline::get<std::string>( "-metrics", "metrics.csv" );
+    bool json = filename.size() > 5 and filename.compare( filename.size() - 5, 5, ".json" ) == 0;
+    struct stat st{};
+    bool empty = ::stat( filename.c_str(), &st ) != 0 or st.st_size == 0;
+    auto fp = std::fopen( filename.c_str(), "a" );
+    if( fp == nullptr ) {
+      std::string note{ "Unable to append metrics to " };
+      note += filename;
+      SC_REPORT_WARNING( MSGID, note.c_str() );
+      return;
+    }
+    using namespace sc_core;
+    const double elaboration = seconds( m_begin, m_start );
+    const double simulation  = seconds( m_start, m_stop );
+    const auto   lanes       = std::max( Commandline::get<long>( "-lanes", 1 ), 1L );
+    const auto   samples     = static_cast<long>( s_sent );
+    const auto   errors      = sc_report_handler::get_count( SC_ERROR ) + sc_report_handler::get_count( SC_FATAL );
+    const double per_second  = simulation > 0 ? samples / simulation : 0;
+    const double ratio       = simulation > 0 ? sc_time_stamp().to_seconds() / simulation : 0;
+    const double lane_per_s  = per_second / lanes;
+    const double kb_per_lane = double( m_rss_start - m_rss_begin ) / lanes;
+    const auto   activations = static_cast<unsigned long long>( Profile::activations() );
+    const auto   options     = arguments();
+    if( json ) {
+      std::fprintf( fp, "{\"options\":\"%s\",\"samples\":%ld,\"elaboration_s\":%.6f,\"simulation_s\":%.6f"
+                        ",\"samples_per_s\":%.1f,\"sim_per_wall\":%.6g,\"peak_rss_kb\":%ld"
+                        ",\"delta_cycles\":%llu,\"errors\":%d,\"trace_bytes\":%lld"
+                        ",\"lanes\":%ld,\"samples_per_s_per_lane\":%.1f,\"kb_per_lane\":%.1f,\"activations\":%llu}\n"
+                  , options.c_str(), samples, elaboration, simulation, per_second, ratio, peak_rss_kb()
+                  , static_cast<unsigned long long>( sc_delta_count() ), errors, trace_bytes()
+                  , lanes, lane_per_s, kb_per_lane, activations );
+    } else {
+      if( empty ) {
+        std::fprintf( fp, "options,samples,elaboration_s,simulation_s,samples_per_s,sim_per_wall"
+                          ",peak_rss_kb,delta_cycles,errors,trace_bytes"
+                          ",lanes,samples_per_s_per_lane,kb_per_lane,activations\n" );
+      }
+      std::fprintf( fp, "\"%s\",%ld,%.6f,%.6f,%.1f,%.6g,%ld,%llu,%d,%lld,%ld,%.1f,%.1f,%llu\n"
+                  , options.c_str(), samples, elaboration, simulation, per_second, ratio, peak_rss_kb()
+                  , static_cast<unsigned long long>( sc_delta_count() ), errors, trace_bytes()
+                  , lanes, lane_per_s, kb_per_lane, activations );
+    }
+    std::fclose( fp );
+  }
+
+private:
+  static double seconds( Clock::time_point from, Clock::time_point to )
+  {
+    return std::chrono::duration<double>( to - from ).count();
+  }
+  static long peak_rss_kb()
+  {
+    rusage usage{};
+    ::getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+  long long trace_bytes() const ///< Of the waveform file written, otherwise 0
+  {
+    struct stat st{};
+    if( m_trace_filename.empty() or ::stat( m_trace_filename.c_str(), &st ) != 0 ) return 0;
+    return st.st_size;
+  }
+  static std::string arguments() ///< Options except -metrics, without quotes
+  {
+    std::string result;
+    for( int i = 1; i < sc_core::sc_argc(); ++i ) {
+      std::string arg{ sc_core::sc_argv()[ i ] };
+      if( arg.compare( 0, 8, "-metrics" ) == 0 ) continue;
+      for( auto& c : arg ) if( c == '"' or c == '\\' ) c = '\'';
+      if( not result.empty() ) result += ' ';
+      result += arg;
+    }
+    return result;
+  }
+  Clock::time_point m_begin, m_start, m_stop;
+  long              m_rss_begin, m_rss_start{ 0 }; ///< Peak RSS before and after elaboration
+  std::string       m_trace_filename;
+  inline static uint64_t s_sent{ 0 }; ///< By every stimulus
+  static constexpr const char* const MSGID{ "/Doulos/Example/metrics" };
+  inline static const bool described
+  { Commandline::describe( "-metrics=FILE", "Appends performance figures for this run to FILE (.csv or .json)" ) };
+};
+
+// TAF!
@@ -0,0 +1,67 @@
+#pragma once
+
+/** @class Microbench
+
+@brief Per-call cost of reporting, measured in isolation
+
+With `-microbench`, `sc_main` times the statement that `checker_thread()`
+executes for every good sample, instead of simulating:
+
+- `INFO( HIGH, ... )` suppressed at the default verbosity, and
+- the same statement enabled (as with `-verbose`), formatted and displayed.
+
+Results go to stderr in ns per call, so displaying can be measured without
+a terminal: `./run.x -microbench > /dev/null`. `make microbench` runs it
+after timing the reference model paths.
+
+Usage
+-----
+
+```c++
+if( Microbench::requested() ) return Microbench::run();
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "report.hpp"
+#include "commandline.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+struct Microbench
+{
+  static bool requested() { return Commandline::has( "-microbench" ); }
+
+  static int run()
+  {
+    using namespace sc_core;
+    const auto verbosity = sc_report_handler::get_verbosity_level();
+    sc_report_handler::set_verbosity_level( SC_MEDIUM );
+    auto suppressed = ns_per_info( 10'000'000 );
+    sc_report_handler::set_verbosity_level( SC_HIGH );
+    auto enabled = ns_per_info( 100'000 );
+    sc_report_handler::set_verbosity_level( verbosity );
+    std::fprintf( stderr, "INFO(HIGH) per call:\n  %-12s %10.2f ns\n  %-12s %10.2f ns\n"
+                , "suppressed", suppressed, "enabled", enabled );
+    return 0;
+  }
+
+private:
+  static double ns_per_info( uint64_t calls ) ///< As in Observer_module::check()
+  {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for( uint64_t i = 0; i != calls; ++i ) {
+      INFO( HIGH, "Good value 0x" << std::hex << uint16_t( i ) );
+    }
+    return std::chrono::duration<double,std::nano>( Clock::now() - start ).count() / double( calls );
+  }
+  static constexpr const char* const MSGID{ "/Doulos/Example/microbench" };
+  inline static const bool described
+  { Commandline::describe( "-microbench", "Times INFO(HIGH) suppressed and enabled instead of simulating" ) };
+};
+
+// TAF!
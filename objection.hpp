@@ -26,13 +26,48 @@ is raised.
 Simply `Objection("name")` in threads at points where activity is starting.
 Make sure the objection object has a well-defined life-time. The
 construction string provided provides and identifier for the specific
-objection.
+objection. Several objections may share a name; each name keeps a count
+of its outstanding objections (see `Objection::count(name)`).
+
+Names are interned. For objections raised frequently, intern the name
+once and construct from the identifier; raising and dropping are then
+simple counter updates:
+
+```c++
+static const auto busy = Objection::intern( "busy" );
+for(;;) {
+  Objection obj{ busy };
+  ...
+}
+```
 
 Note: If verbosity is set to SC_DEBUG, then messages will be produced
 as objections are raised and dropped.
 
 Simulation will stop after destruction of the last objection.
 
+Drop modes
+----------
+
+By default (`Objection::Mode::yield`) dropping the last objection waits a
+delta cycle so that the objector can start draining. In
+`Objection::Mode::deferred` (`-objection=deferred`) a drop never suspends
+the caller, so objections may also be used in SC_METHODs; the objector
+alone schedules a single drain check at the end of the drain-time, pushed
+out by any later drops.
+
+Scopes
+------
+
+An objection may be attributed to a module (usually `this`). When the
+simulation times out or stops while objections remain, the objector
+reports which subtrees of the hierarchy still hold objections, similar to
+UVM's objection trace.
+
+```c++
+Objection obj{ busy, this };
+```
+
 Example
 -------
 
@@ -48,60 +83,125 @@ void Stimulus_module::main_thread()
 */
 #include "systemc.hpp"
 #include "report.hpp"
+#include "commandline.hpp"
+#include "profile.hpp"
+#include "checkpoint.hpp"
+#include <map>
 #include <string>
-#include <set>
+#include <unordered_map>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 struct Objection
 {
-  Objection( const std::string& name ) ///< Create an objection
-  : m_name( name )
+  using Id = size_t;
+  enum class Mode { yield, deferred };
+  static Id intern( const std::string& name ) ///< Return identifier for name
   {
     sc_assert( name.size() > 0 );
+    auto [ elt, inserted ] = ids.try_emplace( name, names.size() );
+    if( inserted ) {
+      names.push_back( name );
+      counts.push_back( 0u );
+    }
+    return elt->second;
+  }
+  explicit Objection( Id id, const sc_core::sc_object* scope = nullptr ) ///< Create an objection
+  : m_id( id )
+  , m_scope( scope )
+  {
     sc_assert( ready );
-    objections.insert( m_name );
-    std::string note{ "Raising objection " };
-    note += m_name;
-    INFO( DEBUG, note );
+    sc_assert( m_id < counts.size() );
+    ++counts[ m_id ];
+    ++outstanding;
     ++created;
+    if( m_scope != nullptr ) ++scopes[ m_scope ];
+    INFO( DEBUG, "Raising objection " << names[ m_id ] );
+  }
+  Objection( const std::string& name, const sc_core::sc_object* scope = nullptr ) ///< Create an objection
+  : Objection( intern( name ), scope )
+  {
   }
   ~Objection() ///< Remove an objection
   {
-    auto elt = objections.find( m_name );
-    sc_assert( elt != objections.end() );
-    objections.erase( elt );
-    std::string note{ "Dropping objection " };
-    note += m_name;
-    INFO( DEBUG, note );
-    if( objections.empty() and sc_core::sc_is_running() ) 
+    sc_assert( counts[ m_id ] > 0 );
+    --counts[ m_id ];
+    --outstanding;
+    if( m_scope != nullptr ) --scopes[ m_scope ];
+    INFO( DEBUG, "Dropping objection " << names[ m_id ] );
+    if( outstanding == 0 and sc_core::sc_is_running() ) 
     {
       INFO( DEBUG, "No objections remain" );
-      stop_reason = note;
-      stop_event.notify(sc_core::SC_ZERO_TIME);
-      wait( sc_core::SC_ZERO_TIME );
+      stop_id = m_id;
+      if( mode == Mode::deferred ) {
+        // Objector checks once the drain-time has passed
+        last_drop = sc_core::sc_time_stamp();
+        if( not drain_pending ) {
+          drain_pending = true;
+          stop_event.notify( drain_time );
+        }
+      } else {
+        stop_event.notify(sc_core::SC_ZERO_TIME);
+        Profile::wait( sc_core::SC_ZERO_TIME );
+      }
     }
   }
+  Objection( const Objection& ) = delete;
+  Objection& operator=( const Objection& ) = delete;
   static size_t total() { return created; } ///< Return total times used
-  static size_t count() { return objections.size(); } ///< Return the outstanding objections
+  static size_t count() { return outstanding; } ///< Return the outstanding objections
+  static size_t count( const std::string& name ) ///< Return the outstanding objections for name
+  {
+    auto elt = ids.find( name );
+    return elt == ids.end() ? 0u : counts[ elt->second ];
+  }
+  static void report_holders() ///< Report which names and subtrees hold objections
+  {
+    for( Id id = 0; id < counts.size(); ++id ) {
+      if( counts[ id ] != 0 ) {
+        INFO( NONE, "Objection " << names[ id ] << " outstanding " << counts[ id ] << " time(s)" );
+      }
+    }
+    std::map<std::string,size_t> subtrees;
+    for( const auto& [ scope, n ] : scopes ) {
+      if( n == 0 ) continue;
+      for( auto obj = scope; obj != nullptr; obj = obj->get_parent_object() ) {
+        subtrees[ obj->name() ] += n;
+      }
+    }
+    for( const auto& [ name, n ] : subtrees ) {
+      INFO( NONE, "Subtree " << name << " holds " << n << " objection(s)" );
+    }
+  }
+  static void set_mode( Mode m ) { Objection::mode = m; }
+  static Mode get_mode() { return Objection::mode; }
   static void set_drain_time( sc_core::sc_time delay ) { Objection::drain_time = delay; }
   static sc_core::sc_time get_drain_time() { return Objection::drain_time; }
   void set_timeout( sc_core::sc_time delay )
   {
     timeout = delay;
     timeout_event.notify(sc_core::SC_ZERO_TIME);
-    wait( sc_core::SC_ZERO_TIME );
+    Profile::wait( sc_core::SC_ZERO_TIME );
   }
 private:
   friend struct Objector_module;
-  std::string m_name;
+  Id                         m_id;
+  const sc_core::sc_object*  m_scope;
   // Static stuff
   static constexpr const char* const       MSGID { "/Doulos/Objection" };
   inline static sc_core::sc_time           drain_time{ sc_core::SC_ZERO_TIME };
   inline static size_t                     created{ 0u };
+  inline static size_t                     outstanding{ 0u };
   inline static sc_core::sc_process_handle timer_handle;
-  inline static std::set<std::string>      objections;
+  inline static std::unordered_map<std::string,Id> ids;
+  inline static std::vector<std::string>   names;  ///< Indexed by Id
+  inline static std::vector<size_t>        counts; ///< Outstanding, indexed by Id
+  inline static std::unordered_map<const sc_core::sc_object*,size_t> scopes; ///< Outstanding per scope
+  inline static Mode                       mode{ Mode::yield };
+  inline static sc_core::sc_time           last_drop{ sc_core::SC_ZERO_TIME };
+  inline static bool                       drain_pending{ false };
   inline static sc_core::sc_event          stop_event;
-  inline static std::string                stop_reason{ "unknown" };
+  inline static Id                         stop_id{ 0u };
   inline static sc_core::sc_event          timeout_event;
   inline static sc_core::sc_time           timeout{ sc_core::SC_ZERO_TIME };
   inline static bool                       ready{ false };
@@ -109,10 +209,10 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 // Module to shutdown SystemC on request
-struct Objector_module: sc_core::sc_module
+struct Objector_module: Profiled_module
 {
   Objector_module( sc_core::sc_module_name instance )
-  : sc_module( instance )
+  : Profiled_module( instance )
   {
     SC_HAS_PROCESS( Objector_module );
     SC_THREAD( objection_thread );
@@ -120,9 +220,30 @@ struct Objector_module: sc_core::sc_module
     if( Objection::get_drain_time() == sc_core::SC_ZERO_TIME ) {
       Objection::set_drain_time( sc_core::sc_time( 10, sc_core::SC_NS ));
     }
+    auto& MSGID{ Objection::MSGID };
+    auto mode = Commandline::get<std::string>( "-objection", "yield" );
+    if( mode == "deferred" ) {
+      Objection::set_mode( Objection::Mode::deferred );
+    } else if( mode != "yield" ) {
+      REPORT( ERROR, "Unknown objection mode " << mode << "; using yield" );
+    }
     Objection::ready = true;
+    // Outstanding objections are raised again by the restarted processes
+    Checkpoint::add( this
+    , []( Checkpoint::Writer& out ) {
+        out.put( Objection::names );
+        out.put( Objection::created );
+      }
+    , []( Checkpoint::Reader& in ) {
+        std::vector<std::string> names;
+        in.get( names );
+        for( const auto& name : names ) Objection::intern( name );
+        in.get( Objection::created );
+      } );
   }
 private:
+  inline static const bool described
+  { Commandline::describe( "-objection=MODE", "Objection drop MODE: yield (default) or deferred" ) };
   // Shuts down if last objection raised
   void objection_thread()
   {
@@ -130,14 +251,23 @@ private:
     for(;;) {
       wait( Objection::stop_event );
       // Grab reason while waiting
-      auto reason = std::exchange( Objection::stop_reason, "unknown"s );
-      // Allow drainage
-      DEBUG( "Draining" );
-      wait( Objection::drain_time );
-      if( Objection::objections.empty() ) {
-        std::string note{ "Shutting down " };
-        note += reason;
-        INFO( NONE, note );
+      auto reason = Objection::stop_id;
+      if( Objection::mode == Objection::Mode::deferred ) {
+        // Drain-time already elapsed, unless later drops extended it
+        for(;;) {
+          auto deadline = Objection::last_drop + Objection::drain_time;
+          if( Objection::outstanding != 0 or sc_core::sc_time_stamp() >= deadline ) break;
+          wait( deadline - sc_core::sc_time_stamp() );
+        }
+        Objection::drain_pending = false;
+        reason = Objection::stop_id;
+      } else {
+        // Allow drainage
+        DEBUG( "Draining" );
+        wait( Objection::drain_time );
+      }
+      if( Objection::outstanding == 0 ) {
+        INFO( NONE, "Shutting down Dropping objection " << Objection::names[ reason ] );
         sc_core::sc_stop();
       }
     }
@@ -148,9 +278,10 @@ private:
     for(;;) {
       wait( Objection::timeout_event );
       auto stop_time = sc_core::sc_time_stamp() + Objection::timeout;
-      sc_core::wait( Objection::timeout, Objection::timeout_event );
+      wait( Objection::timeout, Objection::timeout_event );
       if( sc_core::sc_time_stamp() == stop_time ) {
         SC_REPORT_WARNING( MSGID, "Timed out - shutting down" );
+        Objection::report_holders();
         sc_core::sc_stop();
       }
     }
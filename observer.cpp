@@ -1,7 +1,9 @@
 #include "observer.hpp"
-#include "objection.hpp"
 #include "top.hpp"
+#include "commandline.hpp"
+#include "checkpoint.hpp"
 #include "systemc.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <string>
 
@@ -9,63 +11,332 @@ using namespace sc_core;
 
 namespace {
   constexpr char const* const MSGID{ "/Doulos/Example/tracing" };
+  [[maybe_unused]] const bool described {
+        Commandline::describe( "-scoreboard=N", "Holds up to N outstanding expectations (default 1024)" )
+    and Commandline::describe( "-out-of-order", "Matches results to expectations by value rather than in order" )
+    and Commandline::describe( "-golden=FILE",  "Checks results against FILE instead of the kernel's transform" )
+    and Commandline::describe( "-golden-capture=FILE", "Records every result, with its time, to FILE for -golden" )
+  };
+
+  // -scoreboard, checked once for every lane
+  size_t scoreboard_capacity()
+  {
+    constexpr size_t dflt{ 1024 };
+    static const size_t capacity = [] {
+      auto result = Commandline::get<size_t>( "-scoreboard", dflt );
+      if( result == 0 ) {
+        REPORT( ERROR, "Scoreboard capacity (-scoreboard) should be at least 1; using " << dflt );
+        result = dflt;
+      }
+      return result;
+    }();
+    return capacity;
+  }
 }
 
-Observer_module::Observer_module( sc_module_name instance )
-: sc_module( instance )
+template<typename T>
+Observer_module<T>::Observer_module( sc_module_name instance, const std::string& kernel_name )
+: Profiled_module( instance )
+, scoreboard( scoreboard_capacity(), Commandline::has( "-out-of-order" ) )
+, kernel( Kernel_registry::info<T>( kernel_name ) )
 {
   SC_HAS_PROCESS( Observer_module );
-  SC_THREAD( prepare_thread );
-  SC_THREAD( checker_thread );
+  if( Commandline::has( "-methods" ) ) {
+    SC_METHOD( prepare_method );
+    SC_METHOD( checker_method );
+  } else {
+    SC_THREAD( prepare_thread );
+    SC_THREAD( checker_thread );
+  }
   actual_export.bind( actual_data );
+  burst_actual_export.bind( actual_bursts );
+  if( Commandline::has( "-golden" ) ) {
+    comparing = golden.open( Top_module::lane_file( Commandline::get<std::string>( "-golden", "" ), this )
+                           , Payload<T>::bytes );
+  }
+  if( Commandline::has( "-golden-capture" ) ) {
+    golden_capture.open( Top_module::lane_file( Commandline::get<std::string>( "-golden-capture", "golden.stim" ), this )
+                       , Payload<T>::bytes );
+  }
+
+  Checkpoint::add( this
+  , [this]( Checkpoint::Writer& out ) {
+      if( not scoreboard.empty() ) {
+        REPORT( WARNING, "Checkpoint taken with " << scoreboard.size()
+                         << " expectation(s) outstanding; results in flight are not saved" );
+      }
+      out.put( observed_count );
+      out.put( failures_count );
+      out.put( received_value );
+      out.put( expected_value );
+      out.put( actual_value );
+      out.put( golden_next );
+      out.put( results );
+      scoreboard.save( out );
+    }
+  , [this]( Checkpoint::Reader& in ) {
+      in.get( observed_count );
+      in.get( failures_count );
+      in.get( received_value );
+      in.get( expected_value );
+      in.get( actual_value );
+      in.get( golden_next );
+      in.get( results );
+      scoreboard.load( in );
+      // Errors reported before the checkpoint still fail the run
+      if( failures_count != 0 ) {
+        REPORT( ERROR, failures_count << " failure(s) before the checkpoint" );
+      }
+    } );
+}
+
+template<typename T>
+void Observer_module<T>::end_of_elaboration()
+{
+  if( expect_port.size() == burst_expect_port.size() ) {
+    SC_REPORT_FATAL( MSGID, "Exactly one of expect_port or burst_expect_port must be connected" );
+  }
 }
 
-void Observer_module::start_of_simulation()
+template<typename T>
+void Observer_module<T>::start_of_simulation()
 {
+  if( comparing ) {
+    INFO( MEDIUM, "Expectations from " << golden.size() << " golden results" );
+  } else if constexpr( std::is_same_v<T,Data_t> ) {
+    // Selects the batch path before simulation starts
+    INFO( MEDIUM, "Expectations from kernel " << kernel.name
+                << " (reference model batch path " << Reference_model::isa() << ")" );
+  } else {
+    INFO( MEDIUM, "Expectations from kernel " << kernel.name
+                << " for " << Payload_registry::name<T>() << " payloads" );
+  }
   const auto& trace_file { Top_module::trace_file() };
   if( trace_file != nullptr ) {
     auto prefix = std::string(name()) + ".";
-    sc_trace( trace_file, received_value, prefix + "received_value" );
-    sc_trace( trace_file, expected_value, prefix + "expected_value" );
-    sc_trace( trace_file, actual_value  , prefix + "actual_value" );
-    sc_trace( trace_file, observed_count, prefix + "observed_count" );
-    sc_trace( trace_file, failures_count, prefix + "failures_count" );
+    Top_module::trace( received_value, prefix + "received_value" );
+    Top_module::trace( expected_value, prefix + "expected_value" );
+    Top_module::trace( actual_value  , prefix + "actual_value" );
+    Top_module::trace( observed_count, prefix + "observed_count" );
+    Top_module::trace( failures_count, prefix + "failures_count" );
   }
 }
 
-void Observer_module::prepare_thread()
+template<typename T>
+void Observer_module<T>::end_of_simulation()
+{
+  scoreboard.report( ( std::string( name() ) + ".scoreboard" ).c_str()
+                  , Commandline::get<size_t>( "-lanes", 1 ) > 1 );
+  if( comparing and golden_next < golden.size() ) {
+    REPORT( WARNING, "Only " << golden_next << " of " << golden.size() << " golden results were expected" );
+  }
+  if( Commandline::has( "-golden-capture" ) ) {
+    golden_capture.close();
+    INFO( MEDIUM, "Captured " << golden_capture.size() << " golden results" );
+  }
+}
+
+// Expectations from the golden file; returns how many of n remain in it
+template<typename T>
+size_t Observer_module<T>::from_golden( T* expected, size_t n )
+{
+  size_t available = golden_next < golden.size() ? std::min<uint64_t>( n, golden.size() - golden_next ) : 0;
+  golden.copy( golden_next, expected, available );
+  if( available != n and golden_next <= golden.size() ) {
+    REPORT( ERROR, "Golden file ends after result " << golden.size() );
+  }
+  golden_next += n;
+  return available;
+}
+
+// Convert a value sent out into an expected value
+template<typename T>
+void Observer_module<T>::prepare( const T& received )
+{
+  received_value = received;
+  T computed_value{};
+  if( not comparing ) {
+    computed_value = kernel.transform( received_value );
+  } else if( from_golden( &computed_value, 1 ) == 0 ) {
+    return;
+  }
+  DEBUG( "Computed " << std::hex << printable( computed_value ) );
+  // Signals cannot be held back, so an overflow is reported instead
+  if( not scoreboard.nb_put( computed_value ) ) {
+    REPORT( ERROR, "Scoreboard full (see -scoreboard=N); dropped expectation 0x"
+                   << std::hex << printable( computed_value ) );
+  }
+}
+
+// Expectations for a whole burst are computed as one batch
+template<typename T>
+void Observer_module<T>::prepare( const Burst<T>& received )
+{
+  computed.resize( received.size() );
+  size_t n = received.size();
+  if( comparing ) {
+    n = from_golden( computed.data(), n );
+  } else {
+    kernel.batch( received.begin(), computed.data(), n );
+  }
+  for( size_t i = 0; i != n; ++i ) {
+    received_value = received[ i ];
+    if( not scoreboard.nb_put( computed[ i ] ) ) {
+      REPORT( ERROR, "Scoreboard full (see -scoreboard=N); dropped expectations from " << received );
+      break;
+    }
+  }
+  DEBUG( "Computed expectations for " << received );
+}
+
+template<typename T>
+void Observer_module<T>::prepare_thread()
 {
   INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
   // Obtain values sent out and convert into expected values
+  if( expect_port.size() != 0 ) {
+    for(;;) {
+      wait( expect_port->value_changed_event() );
+      prepare( expect_port->read() );
+    }
+  }
   for(;;) {
-    wait( expect_port->value_changed_event() );
-    received_value = expect_port->read();
-    auto computed_value = ~std::hash<Data_t>{}( received_value ) & ~Data_t();
-    DEBUG( "Computed " << std::hex << computed_value );
-    expected_fifo.put( computed_value );
+    wait( burst_expect_port->value_changed_event() );
+    prepare( burst_expect_port->read() );
+  }
+}
+
+template<typename T>
+void Observer_module<T>::prepare_method()
+{
+  Profile::Scope scope;
+  if( prepare_phase == Phase::start ) {
+    INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
+    prepare_phase = Phase::expect;
+  } else if( expect_port.size() != 0 ) {
+    prepare( expect_port->read() );
+  } else {
+    prepare( burst_expect_port->read() );
+  }
+  if( expect_port.size() != 0 ) {
+    next_trigger( expect_port->value_changed_event() );
+  } else {
+    next_trigger( burst_expect_port->value_changed_event() );
   }
 }
 
-void Observer_module::checker_thread()
+template<typename T>
+void Observer_module<T>::checker_thread()
 {
   INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
+  if( expect_port.size() != 0 ) {
+    for(;;) {
+      while( scoreboard.empty() ) wait( scoreboard.ok_to_get() ); // Wait for new expected value
+      {
+        Objection obj{ observing, this }; // Raise objection on creation
+        wait( actual_data.value_changed_event() );
+        check( actual_data.read(), sc_time_stamp() );
+      }
+    }
+  }
   for(;;) {
-    expected_value = expected_fifo.get(); // Wait for new expected value
+    while( scoreboard.empty() ) wait( scoreboard.ok_to_get() ); // Wait for expectations of a burst
     {
-      Objection obj{ "Observing" }; // Raise objection on creation
-      wait( actual_data.value_changed_event() );
-      actual_value = actual_data.read();
-      ++observed_count;
-      // Do the values match?
-      if( actual_value == expected_value ) {
-        INFO( HIGH, "Good value 0x" << std::hex << actual_value );
-      } else {
-        REPORT(ERROR, std::hex << "Mismatch got 0x" << actual_value
-                   << " != expected 0x" << expected_value );
-        ++failures_count;
-      }
+      Objection obj{ observing, this }; // Raise objection on creation
+      wait( actual_bursts.value_changed_event() );
+      check( actual_bursts.read() );
+    }
+  }
+}
+
+// Same as checker_thread(); requires Objection::Mode::deferred as
+// dropping the objection must not suspend.
+template<typename T>
+void Observer_module<T>::checker_method()
+{
+  Profile::Scope scope;
+  const bool bursts = burst_expect_port.size() != 0;
+  for(;;) {
+    switch( checker_phase ) {
+      case Phase::start:
+        INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
+        sc_assert( Objection::get_mode() == Objection::Mode::deferred );
+        checker_phase = Phase::expect;
+        break;
+      case Phase::expect:
+        if( scoreboard.empty() ) {
+          next_trigger( scoreboard.ok_to_get() );
+          return;
+        }
+        objection.emplace( observing, this ); // Raise objection
+        checker_phase = Phase::actual;
+        next_trigger( bursts ? actual_bursts.value_changed_event()
+                             : actual_data.value_changed_event() );
+        return;
+      case Phase::actual:
+        if( bursts ) {
+          check( actual_bursts.read() );
+        } else {
+          check( actual_data.read(), sc_time_stamp() );
+        }
+        objection.reset(); // Drop objection
+        checker_phase = Phase::expect;
+        break;
     }
   }
 }
 
+template<typename T>
+void Observer_module<T>::check( const Burst<T>& actual )
+{
+  for( size_t i = 0; i != actual.size(); ++i ) {
+    check( actual[ i ], actual.time_of( i ) );
+  }
+}
+
+// Match a result against the scoreboard
+template<typename T>
+void Observer_module<T>::check( const T& actual, const sc_time& when )
+{
+  golden_capture.append( when, actual );
+  ++results;
+  if( auto match = scoreboard.match( actual ); match.found ) {
+    check( match.expected, actual, when );
+    return;
+  }
+  actual_value = actual;
+  ++observed_count;
+  REPORT( ERROR, std::hex << "Unexpected 0x" << printable( actual_value )
+                << std::dec << " for result " << results - 1 << " due at " << when );
+  ++failures_count;
+  Top_module::trace_trigger();
+}
+
+// Compare a result due at the specified (possibly annotated) time
+template<typename T>
+void Observer_module<T>::check( const T& expected, const T& actual, const sc_time& when )
+{
+  expected_value = expected;
+  actual_value   = actual;
+  ++observed_count;
+  // Do the values match?
+  if( actual_value == expected_value ) {
+    INFO( HIGH, "Good value 0x" << std::hex << printable( actual_value ) );
+  } else {
+    REPORT(ERROR, std::hex << "Mismatch got 0x" << printable( actual_value )
+               << " != " << ( comparing ? "golden" : "expected" ) << " 0x" << printable( expected_value )
+               << std::dec << " for result " << results - 1 << " due at " << when );
+    ++failures_count;
+    Top_module::trace_trigger();
+  }
+}
+
+// One instantiation per Payload_registry::List entry
+template struct Observer_module<uint16_t>;
+template struct Observer_module<uint8_t>;
+template struct Observer_module<uint32_t>;
+template struct Observer_module<uint64_t>;
+template struct Observer_module<sc_dt::sc_bv<512>>;
+template struct Observer_module<sc_dt::sc_biguint<512>>;
+
 // TAF!
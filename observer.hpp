@@ -1,25 +1,61 @@
 #pragma once
 
 #include "systemc.hpp"
-#include "tlm.hpp"
 #include "common.hpp"
+#include "burst.hpp"
+#include "objection.hpp"
+#include "scoreboard.hpp"
+#include "kernel.hpp"
+#include "stim_file.hpp"
+#include "payload.hpp"
+#include <optional>
+#include <vector>
 
-struct Observer_module : sc_core::sc_module
+template<typename T>
+struct Observer_module : Profiled_module
 {
-  sc_core::sc_export<sc_core::sc_signal_out_if<Data_t>> actual_export { "actual_export" };
-  sc_core::sc_port<sc_core::sc_signal_in_if<Data_t>>    expect_port   { "expect_port" };
-  sc_core::sc_port<sc_core::sc_signal_in_if<bool>>      running_port  { "running_port" };
-  Observer_module( sc_core::sc_module_name instance );
+  // Connect either the sample or the burst expect_port
+  constexpr static auto BIND = sc_core::SC_ZERO_OR_MORE_BOUND;
+  sc_core::sc_export<sc_core::sc_signal_out_if<T>>          actual_export       { "actual_export" };
+  sc_core::sc_export<sc_core::sc_signal_out_if<Burst<T>>>   burst_actual_export { "burst_actual_export" };
+  sc_core::sc_port<sc_core::sc_signal_in_if<T>,1,BIND>        expect_port       { "expect_port" };
+  sc_core::sc_port<sc_core::sc_signal_in_if<Burst<T>>,1,BIND> burst_expect_port { "burst_expect_port" };
+  sc_core::sc_port<sc_core::sc_signal_in_if<bool>>          running_port        { "running_port" };
+  Observer_module( sc_core::sc_module_name instance, const std::string& kernel_name ); ///< Same kernel as the behavior
   void start_of_simulation();
+  void end_of_simulation();
   void prepare_thread();
   void checker_thread();
+  void prepare_method(); // -methods replacements
+  void checker_method();
 private:
-  uint16_t observed_count{ 0 };
-  uint16_t failures_count{ 0 };
-  sc_core::sc_signal<Data_t> actual_data;
-  tlm::tlm_fifo<Data_t> expected_fifo{ -1 }; // unbounded
+  void end_of_elaboration();
+  void prepare( const T& received );
+  void prepare( const Burst<T>& received );
+  void check( const T& expected, const T& actual, const sc_core::sc_time& when );
+  void check( const T& actual, const sc_core::sc_time& when );
+  void check( const Burst<T>& actual );
+  size_t from_golden( T* expected, size_t n );
+  Objection::Id observing{ Objection::intern( "Observing" ) };
+  // Method state
+  enum class Phase { start, expect, actual };
+  Phase prepare_phase{ Phase::start };
+  Phase checker_phase{ Phase::start };
+  std::optional<Objection> objection; // Held while awaiting a result
+  uint64_t observed_count{ 0 };
+  uint64_t failures_count{ 0 };
+  sc_core::sc_signal<T> actual_data;
+  sc_core::sc_signal<Burst<T>> actual_bursts;
+  Scoreboard<T, typename Payload<T>::Hash> scoreboard; // -scoreboard, -out-of-order
+  std::vector<T> computed; // Batch of expectations for a burst
+  Kernel_info<T> kernel; // Same as the behavior's
+  bool        comparing{ false }; // -golden
+  Stim_reader golden;             // Expected results instead of the kernel
+  Stim_writer golden_capture;     // -golden-capture
+  uint64_t    golden_next{ 0 };   // Next golden result to expect
+  uint64_t    results{ 0 };       // Results checked
   // Following are here only for tracing purposes
-  Data_t received_value{};
-  Data_t expected_value{};
-  Data_t actual_value{};
+  T received_value{};
+  T expected_value{};
+  T actual_value{};
 };
@@ -0,0 +1,237 @@
+#pragma once
+
+/** @class Payload
+
+@brief Per-type operations on the data carried by the pipeline
+
+The stimulus, behavior and observer are templates on their payload type.
+Everything they need to know about that type is in `Payload<T>`:
+
+- `width` in bits and `bytes` when stored;
+- `fill( rng, out, n )` to draw uniformly distributed values;
+- `flip( value, bit )` to inject a single-bit error;
+- `invert( value )` and `rotate( value, k )` for the transforms;
+- `Hash` for the scoreboard's out-of-order index;
+- `store( value, bytes )` and `load( bytes, value )` for stimulus, golden
+  and checkpoint files (little-endian words).
+
+`printable( value )` streams any payload, so a `uint8_t` shows as a number.
+
+It is specialized for unsigned integers of 8 to 64 bits, which use plain
+arithmetic, and for `sc_dt::sc_bv<N>` and `sc_dt::sc_biguint<N>`. The wide
+types avoid the bit-by-bit and string paths of `sc_dt`: `sc_bv<N>` works
+on 32-bit words through `get_word()` and `set_word()`, and
+`sc_biguint<N>` on 64-bit chunks with shifts, `|` and `to_uint64()`,
+which work on whole digits. Neither converts to the other, as
+`sc_unsigned` to `sc_bv_base` assignment goes bit by bit.
+
+`-payload=NAME` selects one of `Payload_registry::List` at run time, in
+the same way as `-kernel` (see kernel.hpp).
+
+Adding a payload type
+---------------------
+
+Specialize `Payload<T>` if needed, add `T` to `Payload_registry::List`,
+and add explicit instantiations at the end of stimulus.cpp, behavior.cpp
+and observer.cpp.
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "common.hpp"
+#include "commandline.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+template<typename T, typename Enable = void>
+struct Payload; // Unsupported type
+
+//------------------------------------------------------------------------------
+// Unsigned integers of 8 to 64 bits
+template<typename T>
+struct Payload<T, std::enable_if_t<std::is_integral_v<T> and std::is_unsigned_v<T> and not std::is_same_v<T,bool>>>
+{
+  static constexpr int    width{ 8 * sizeof( T ) };
+  static constexpr size_t bytes{ sizeof( T ) };
+  static void fill( Random& rng, T* out, size_t n ) { rng.fill( out, n ); }
+  static void flip( T& value, int bit ) { value ^= T( T( 1 ) << bit ); }
+  static T invert( const T& value ) { return T( ~value ); }
+  static T rotate( const T& value, int k ) { return T( ( value << k ) | ( value >> ( width - k ) ) ); }
+  using Hash = std::hash<T>;
+  static void store( const T& value, unsigned char* out ) { std::memcpy( out, &value, bytes ); }
+  static void load( const unsigned char* in, T& value ) { std::memcpy( &value, in, bytes ); }
+};
+
+//------------------------------------------------------------------------------
+// Bit vectors of any width, a word at a time
+template<int N>
+struct Payload<sc_dt::sc_bv<N>>
+{
+  using T = sc_dt::sc_bv<N>;
+  static constexpr int    width{ N };
+  static constexpr int    words{ ( N + 31 ) / 32 };
+  static constexpr size_t bytes{ 4 * words };
+  static void fill( Random& rng, T* out, size_t n )
+  {
+    for( size_t i = 0; i != n; ++i ) {
+      uint64_t r = 0;
+      for( int w = 0; w != words; ++w ) {
+        if( w % 2 == 0 ) r = rng.next();
+        out[ i ].set_word( w, uint32_t( r >> ( 32 * ( w % 2 ) ) ) & mask( w ) );
+      }
+    }
+  }
+  static void flip( T& value, int bit )
+  {
+    value.set_word( bit / 32, value.get_word( bit / 32 ) ^ ( 1u << ( bit % 32 ) ) );
+  }
+  static T invert( const T& value )
+  {
+    T result;
+    for( int w = 0; w != words; ++w ) result.set_word( w, ~value.get_word( w ) & mask( w ) );
+    return result;
+  }
+  static T rotate( const T& value, int k )
+  {
+    T result{ value };
+    result.lrotate( k );
+    return result;
+  }
+  struct Hash
+  {
+    size_t operator()( const T& value ) const
+    {
+      uint64_t result = 0xCBF29CE484222325u;
+      for( int w = 0; w != words; ++w ) result = ( result ^ value.get_word( w ) ) * 0x100000001B3u;
+      return size_t( result ^ ( result >> 32 ) );
+    }
+  };
+  static void store( const T& value, unsigned char* out )
+  {
+    for( int w = 0; w != words; ++w ) {
+      uint32_t word = value.get_word( w );
+      for( int b = 0; b != 4; ++b ) out[ 4 * w + b ] = uint8_t( word >> ( 8 * b ) );
+    }
+  }
+  static void load( const unsigned char* in, T& value )
+  {
+    for( int w = 0; w != words; ++w ) {
+      uint32_t word = 0;
+      for( int b = 0; b != 4; ++b ) word |= uint32_t( in[ 4 * w + b ] ) << ( 8 * b );
+      value.set_word( w, word & mask( w ) );
+    }
+  }
+private:
+  static constexpr uint32_t mask( int w ) ///< Bits of word w that are in the vector
+  {
+    return w != words - 1 or N % 32 == 0 ? ~0u : ( 1u << ( N % 32 ) ) - 1;
+  }
+};
+
+//------------------------------------------------------------------------------
+// Arbitrary-precision unsigned integers, 64 bits at a time
+template<int N>
+struct Payload<sc_dt::sc_biguint<N>>
+{
+  using T = sc_dt::sc_biguint<N>;
+  static constexpr int    width{ N };
+  static constexpr int    chunks{ ( N + 63 ) / 64 };
+  static constexpr size_t bytes{ 4 * ( ( N + 31 ) / 32 ) }; ///< As for sc_bv<N>
+  static void fill( Random& rng, T* out, size_t n )
+  {
+    for( size_t i = 0; i != n; ++i ) {
+      T value{ 0u };
+      for( int c = chunks; c-- != 0; ) value = T( ( value << 64 ) | T( rng.next() & mask( c ) ) );
+      out[ i ] = value;
+    }
+  }
+  static void flip( T& value, int bit ) { value.invert( bit ); }
+  static T invert( const T& value ) { return T( ~value ); }
+  static T rotate( const T& value, int k ) { return T( ( value << k ) | ( value >> ( N - k ) ) ); }
+  struct Hash
+  {
+    size_t operator()( const T& value ) const
+    {
+      uint64_t result = 0xCBF29CE484222325u;
+      for( int c = 0; c != chunks; ++c ) result = ( result ^ chunk( value, c ) ) * 0x100000001B3u;
+      return size_t( result ^ ( result >> 32 ) );
+    }
+  };
+  static void store( const T& value, unsigned char* out )
+  {
+    for( int c = 0; c != chunks; ++c ) {
+      uint64_t part = chunk( value, c );
+      for( size_t b = 8 * c; b != std::min( bytes, size_t( 8 * c + 8 ) ); ++b, part >>= 8 ) out[ b ] = uint8_t( part );
+    }
+  }
+  static void load( const unsigned char* in, T& value )
+  {
+    value = 0u;
+    for( int c = chunks; c-- != 0; ) {
+      uint64_t part = 0;
+      for( size_t b = std::min( bytes, size_t( 8 * c + 8 ) ); b-- != size_t( 8 * c ); ) part = ( part << 8 ) | in[ b ];
+      value = T( ( value << 64 ) | T( part & mask( c ) ) );
+    }
+  }
+private:
+  static uint64_t chunk( const T& value, int c ) ///< Bits 64*c and up, on whole digits
+  {
+    return ( value >> ( 64 * c ) ).to_uint64();
+  }
+  static constexpr uint64_t mask( int c ) ///< Bits of chunk c that are in the integer
+  {
+    return c != chunks - 1 or N % 64 == 0 ? ~uint64_t( 0 ) : ( uint64_t( 1 ) << ( N % 64 ) ) - 1;
+  }
+};
+
+//------------------------------------------------------------------------------
+// Streams integers as numbers, including uint8_t, and other types as they are
+template<typename T>
+decltype( auto ) printable( const T& value )
+{
+  if constexpr( std::is_integral_v<T> ) return uint64_t( value );
+  else return value;
+}
+
+//------------------------------------------------------------------------------
+struct Payload_registry
+{
+  using List = std::tuple<uint16_t, uint8_t, uint32_t, uint64_t, sc_dt::sc_bv<512>, sc_dt::sc_biguint<512>>;
+  template<typename F>
+  static void for_each( F&& f ) ///< Calls f( value ) for a value of each payload type
+  {
+    std::apply( [&]( auto... payload ){ ( f( payload ), ... ); }, List{} );
+  }
+  template<typename T>
+  static std::string name() ///< e.g. uint16 or bv512
+  {
+    if constexpr( std::is_integral_v<T> ) return "uint" + std::to_string( Payload<T>::width );
+    else if constexpr( std::is_same_v<T, sc_dt::sc_bv<Payload<T>::width>> ) return "bv" + std::to_string( Payload<T>::width );
+    else return "biguint" + std::to_string( Payload<T>::width );
+  }
+  static std::string selected() ///< Name given by -payload, if known
+  {
+    const std::string dflt{ name<std::tuple_element_t<0,List>>() };
+    auto result = Commandline::get<std::string>( "-payload", dflt );
+    bool known = false;
+    for_each( [&]( auto payload ){ known = known or result == name<decltype( payload )>(); } );
+    if( not known ) {
+      REPORT( ERROR, "Unknown payload " << result << "; using " << dflt );
+      result = dflt;
+    }
+    return result;
+  }
+private:
+  static constexpr const char* const MSGID{ "/Doulos/Example/payload" };
+  inline static const bool described
+  { Commandline::describe( "-payload=NAME", "Payload type NAME: uint16 (default), uint8, uint32, uint64, bv512 or biguint512" ) };
+};
+
+// TAF!
@@ -0,0 +1,240 @@
+#pragma once
+
+/** @class Profile
+
+@brief Per-process activation profiler
+
+With `-profile`, every SystemC process of the design records how often it
+is activated and how much wall time it spends running, using the CPU
+time-stamp counter where available. The table printed at the end of the
+run is sorted by time and includes the time spent in the SystemC kernel
+and in processes that are not profiled. `-profile=FILE` also writes FILE in
+the folded-stack format used by flamegraph tools, with the instance
+hierarchy as the stack.
+
+An activation runs from the moment a process resumes until it suspends:
+
+- Modules derived from `Profiled_module` have their `wait()` calls
+  timed; SC_THREADs need no other changes.
+- SC_METHODs declare a `Profile::Scope` at the top of their body.
+- Code outside modules uses `Profile::wait()` instead of `sc_core::wait()`.
+
+Waits inside library channels (e.g. a blocking `sc_fifo::write()`) would
+not be seen, so profiled processes call `nb_write()` or `nb_read()` and
+wait on the channel's event themselves:
+
+```c++
+while( not fifo.nb_write( value ) ) wait( fifo.data_read_event() );
+```
+
+`Broadcast` FIFO readers already wait through `Profile::wait()`.
+
+When not enabled, each hook costs one test of a flag.
+
+Usage
+-----
+
+```c++
+struct My_module : Profiled_module { ... };  // instead of sc_core::sc_module
+
+Profile::start();                            // Just before sc_start()
+sc_start();
+Profile::stop();
+Profile::report( std::cout );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "commandline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+struct Profile
+{
+  static void start()
+  {
+    s_enabled = true;
+    s_begin   = { ticks(), Clock::now() };
+  }
+  static void stop()
+  {
+    if( not s_enabled ) return;
+    close( ticks() );
+    s_end     = { ticks(), Clock::now() };
+    s_enabled = false;
+  }
+  static void resume() ///< The calling process starts an activation
+  {
+    if( not s_enabled ) return;
+    auto now = ticks();
+    close( now );
+    s_current = &entry();
+    ++s_current->activations;
+    s_since = now;
+  }
+  static void suspend() ///< The calling process ends an activation
+  {
+    if( not s_enabled ) return;
+    if( s_current == nullptr ) {
+      ++entry().activations; // First activation of a thread (not timed)
+    }
+    close( ticks() );
+  }
+  struct Scope ///< Times one activation of an SC_METHOD
+  {
+    Scope()  { resume(); }
+    ~Scope() { suspend(); }
+  };
+  template<typename... Args>
+  static void wait( Args&&... args ) ///< sc_core::wait() for profiled processes
+  {
+    suspend();
+    sc_core::wait( std::forward<Args>( args )... );
+    resume();
+  }
+
+  // Activations of every profiled process
+  static uint64_t activations()
+  {
+    uint64_t result = 0;
+    for( const auto& [ object, entry ] : s_entries ) result += entry.activations;
+    return result;
+  }
+
+  // Table sorted by time, including time outside profiled processes
+  static void report( std::ostream& os )
+  {
+    if( s_entries.empty() ) return;
+    auto rows = sorted();
+    os << "\nProfile (" << ( tsc() ? "TSC" : "steady_clock" ) << "):\n  "
+       << std::left << std::setw( 48 ) << "Process" << std::right
+       << std::setw( 12 ) << "Activations" << std::setw( 12 ) << "Total ms"
+       << std::setw( 12 ) << "Mean ns" << std::setw( 8 ) << "Share" << "\n";
+    const double total = std::max( 1.0, elapsed_ns() );
+    for( const auto& [ name, activations, ns ] : rows ) {
+      os << "  " << std::left << std::setw( 48 ) << name << std::right
+         << std::setw( 12 ) << activations
+         << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << ns / 1e6
+         << std::setw( 12 ) << std::setprecision( 1 ) << ( activations ? ns / activations : 0.0 )
+         << std::setw( 7 ) << 100 * ns / total << "%\n";
+    }
+    os << std::defaultfloat;
+  }
+
+  // Folded stacks (e.g. "top;observer;checker_thread 12345") in nanoseconds
+  static void dump( const std::string& filename )
+  {
+    auto fp = std::fopen( filename.c_str(), "w" );
+    if( fp == nullptr ) {
+      std::string note{ "Unable to write profile " };
+      note += filename;
+      SC_REPORT_WARNING( MSGID, note.c_str() );
+      return;
+    }
+    for( auto [ name, activations, ns ] : sorted() ) {
+      std::replace( name.begin(), name.end(), '.', ';' );
+      std::replace( name.begin(), name.end(), ' ', '_' );
+      std::fprintf( fp, "%s %.0f\n", name.c_str(), ns );
+    }
+    std::fclose( fp );
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Entry {
+    std::string name;
+    uint64_t    activations{ 0 };
+    uint64_t    ticks{ 0 };
+  };
+  struct Stamp {
+    uint64_t          ticks;
+    Clock::time_point time;
+  };
+  static constexpr bool tsc()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return true;
+#else
+    return false;
+#endif
+  }
+  static uint64_t ticks()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return uint64_t( Clock::now().time_since_epoch().count() );
+#endif
+  }
+  static void close( uint64_t now )
+  {
+    if( s_current == nullptr ) return;
+    s_current->ticks += now - s_since;
+    s_current = nullptr;
+  }
+  static Entry& entry()
+  {
+    auto handle = sc_core::sc_get_current_process_handle();
+    auto& result = s_entries[ handle.get_process_object() ];
+    if( result.name.empty() ) result.name = handle.valid() ? handle.name() : "(elaboration)";
+    return result;
+  }
+  static double elapsed_ns()
+  {
+    return std::chrono::duration<double,std::nano>( s_end.time - s_begin.time ).count();
+  }
+  // Rows of { name, activations, ns } sorted by decreasing time
+  static std::vector<std::tuple<std::string,uint64_t,double>> sorted()
+  {
+    const double total = elapsed_ns();
+    const double ns_per_tick = s_end.ticks > s_begin.ticks ? total / double( s_end.ticks - s_begin.ticks ) : 0;
+    std::vector<std::tuple<std::string,uint64_t,double>> rows;
+    double profiled = 0;
+    for( const auto& [ object, entry ] : s_entries ) {
+      rows.emplace_back( entry.name, entry.activations, entry.ticks * ns_per_tick );
+      profiled += entry.ticks * ns_per_tick;
+    }
+    rows.emplace_back( "(kernel and unprofiled)", 0, std::max( 0.0, total - profiled ) );
+    std::sort( rows.begin(), rows.end(), []( const auto& l, const auto& r ){ return std::get<2>( l ) > std::get<2>( r ); } );
+    return rows;
+  }
+  static constexpr const char* const MSGID{ "/Doulos/Example/profile" };
+  inline static const bool described
+  { Commandline::describe( "-profile", "Reports activations and wall time per process" )
+    and Commandline::describe( "-profile=FILE", "Also writes folded stacks to FILE for flamegraph tools" ) };
+  inline static bool     s_enabled{ false };
+  inline static Entry*   s_current{ nullptr };
+  inline static uint64_t s_since{ 0 };
+  inline static Stamp    s_begin{}, s_end{};
+  inline static std::unordered_map<const sc_core::sc_object*,Entry> s_entries;
+};
+
+// Module whose wait() calls are profiled (see Profile)
+struct Profiled_module : sc_core::sc_module
+{
+protected:
+  explicit Profiled_module( const sc_core::sc_module_name& instance ) : sc_module( instance ) {}
+  template<typename... Args>
+  void wait( Args&&... args )
+  {
+    Profile::suspend();
+    sc_module::wait( std::forward<Args>( args )... );
+    Profile::resume();
+  }
+};
+
+// TAF!
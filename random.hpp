@@ -0,0 +1,115 @@
+#pragma once
+
+/** @class Random
+
+@brief Fast, reproducible random streams
+
+A xoshiro256** generator. Each instance is an independent stream whose
+seed is derived from the global `-seed=N` and a name, normally the name of
+the owning `sc_object`. Adding or renaming other modules therefore does
+not change the values seen by existing ones, and a failing seed replays
+exactly.
+
+The name is hashed with FNV-1a rather than `std::hash` so that streams are
+the same with every compiler and library.
+
+`fill()` generates a buffer of small integers using every bit of each
+64-bit draw (four `Data_t` values per step). Values depend on how the
+buffer is split into calls, so the stimulus always fills blocks of the
+same size and consumes them in order, whatever the transport mode.
+`Random` also satisfies *UniformRandomBitGenerator*, so it may be used
+with the standard distributions.
+
+Usage
+-----
+
+```c++
+Random rng{ name() };             // e.g. in a module constructor
+auto bit = rng.below( 16 );       // 0..15
+if( rng.percent( weight ) ) ...
+rng.fill( buffer.data(), buffer.size() );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "commandline.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+class Random
+{
+public:
+  using result_type = uint64_t;
+  explicit Random( const std::string& name ) : Random( seed() ^ hash( name ) ) {}
+  explicit Random( uint64_t seed )
+  {
+    for( auto& word : m_state ) word = splitmix( seed );
+  }
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+  result_type operator()() { return next(); }
+
+  uint64_t next()
+  {
+    const auto result = rotl( m_state[ 1 ] * 5, 7 ) * 9;
+    const auto t      = m_state[ 1 ] << 17;
+    m_state[ 2 ] ^= m_state[ 0 ];
+    m_state[ 3 ] ^= m_state[ 1 ];
+    m_state[ 1 ] ^= m_state[ 2 ];
+    m_state[ 0 ] ^= m_state[ 3 ];
+    m_state[ 2 ] ^= t;
+    m_state[ 3 ]  = rotl( m_state[ 3 ], 45 );
+    return result;
+  }
+
+  // Uniform in 0..n-1 by multiplication rather than division
+  uint32_t below( uint32_t n ) { return uint32_t( ( ( next() >> 32 ) * n ) >> 32 ); }
+
+  // True with a probability of percent/100
+  bool percent( int percent ) { return int( below( 100 ) ) < percent; }
+
+  // Fills out[0..n-1] with uniformly distributed unsigned integers
+  template<typename T>
+  void fill( T* out, size_t n )
+  {
+    static_assert( std::is_unsigned_v<T> and sizeof( T ) <= sizeof( uint64_t ) );
+    constexpr size_t per_draw = sizeof( uint64_t ) / sizeof( T );
+    constexpr unsigned bits   = 8 * sizeof( T );
+    size_t i = 0;
+    for( ; i + per_draw <= n; i += per_draw ) {
+      auto r = next();
+      for( size_t j = 0; j != per_draw; ++j, r >>= ( bits % 64 ) ) out[ i + j ] = T( r );
+    }
+    if( i != n ) {
+      for( auto r = next(); i != n; ++i, r >>= ( bits % 64 ) ) out[ i ] = T( r );
+    }
+  }
+
+  // Global seed from -seed=N
+  static uint64_t seed() { return Commandline::get<uint64_t>( "-seed", 1 ); }
+
+private:
+  static uint64_t rotl( uint64_t x, int k ) { return ( x << k ) | ( x >> ( 64 - k ) ); }
+  static uint64_t splitmix( uint64_t& x )
+  {
+    auto z = ( x += 0x9E3779B97F4A7C15u );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9u;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBu;
+    return z ^ ( z >> 31 );
+  }
+  static uint64_t hash( const std::string& name ) // FNV-1a
+  {
+    uint64_t result = 0xCBF29CE484222325u;
+    for( unsigned char c : name ) result = ( result ^ c ) * 0x100000001B3u;
+    return result;
+  }
+  uint64_t m_state[ 4 ];
+  inline static const bool described
+  { Commandline::describe( "-seed=N", "Seeds every random stream with N (default 1)" ) };
+};
+
+// TAF!
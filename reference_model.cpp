@@ -0,0 +1,74 @@
+#include "reference_model.hpp"
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  void transform_scalar( const Data_t* in, Data_t* out, size_t n )
+  {
+    for( size_t i = 0; i != n; ++i ) out[ i ] = Reference_model::transform( in[ i ] );
+  }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  // The vector paths assume std::hash<Data_t> is the identity, as it is in
+  // the common standard libraries; make test fails otherwise.
+
+  __attribute__((target("sse2")))
+  void transform_sse2( const Data_t* in, Data_t* out, size_t n )
+  {
+    constexpr size_t lanes = sizeof( __m128i ) / sizeof( Data_t );
+    const auto ones = _mm_set1_epi32( -1 );
+    size_t i = 0;
+    for( ; i + lanes <= n; i += lanes ) {
+      auto v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( in + i ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( out + i ), _mm_xor_si128( v, ones ) );
+    }
+    transform_scalar( in + i, out + i, n - i );
+  }
+
+  __attribute__((target("avx2")))
+  void transform_avx2( const Data_t* in, Data_t* out, size_t n )
+  {
+    constexpr size_t lanes = sizeof( __m256i ) / sizeof( Data_t );
+    const auto ones = _mm256_set1_epi32( -1 );
+    size_t i = 0;
+    for( ; i + lanes <= n; i += lanes ) {
+      auto v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( in + i ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + i ), _mm256_xor_si256( v, ones ) );
+    }
+    transform_scalar( in + i, out + i, n - i );
+  }
+#endif
+
+}
+
+void Reference_model::transform( const Data_t* in, Data_t* out, size_t n )
+{
+  path().fn( in, out, n );
+}
+
+const char* Reference_model::isa()
+{
+  return path().name;
+}
+
+const Reference_model::Path& Reference_model::path()
+{
+  static const Path selected = paths().front();
+  return selected;
+}
+
+std::vector<Reference_model::Path> Reference_model::paths()
+{
+  std::vector<Path> result;
+#if defined(__x86_64__) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports( "avx2" ) ) result.push_back( Path{ "avx2", transform_avx2 } );
+  if( __builtin_cpu_supports( "sse2" ) ) result.push_back( Path{ "sse2", transform_sse2 } );
+#endif
+  result.push_back( Path{ "scalar", transform_scalar } );
+  return result;
+}
+
+// TAF!
@@ -0,0 +1,55 @@
+#pragma once
+
+/** @class Reference_model
+
+@brief Transform applied by the behavior and expected by the observer
+
+`transform( value )` is the scalar definition. `transform( in, out, n )`
+applies it to a whole block (e.g. a burst) using the widest SIMD path the
+host supports (AVX2 or SSE2 on x86-64, otherwise scalar), chosen once at
+run time.
+
+The path is chosen from CPUID alone, so nothing is verified at run time.
+`make test` checks every path the host supports against the scalar
+definition for all 65536 possible inputs (reference_model_test.cpp), and
+`make microbench` times each path in ns per sample. `isa()` reports the
+path in use and `paths()` lists them all.
+
+The header does not need SystemC, so the test builds without it.
+
+Usage
+-----
+
+```c++
+auto expected = Reference_model::transform( value );
+Reference_model::transform( samples.data(), results.data(), samples.size() );
+```
+
+********************************************************************************
+*/
+
+#include "data_type.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct Reference_model
+{
+  static Data_t transform( Data_t value ) ///< Scalar definition
+  {
+    return ~std::hash<Data_t>{}( value ) & ~Data_t();
+  }
+  static void transform( const Data_t* in, Data_t* out, size_t n ); ///< Batch
+  static const char* isa(); ///< Batch path in use
+  using Batch_fn = void (*)( const Data_t*, Data_t*, size_t );
+  struct Path {
+    const char* name;
+    Batch_fn    fn;
+  };
+  static std::vector<Path> paths(); ///< Supported by the host, widest first
+private:
+  static const Path& path(); ///< Selected on first use
+};
+
+// TAF!
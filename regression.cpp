@@ -0,0 +1,192 @@
+#include "regression.hpp"
+#include "commandline.hpp"
+#include "report.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace sc_core;
+
+namespace {
+  [[maybe_unused]] const bool described {
+        Commandline::describe( "-regress=SEEDS", "Runs one simulation per seed in SEEDS (e.g. 1-100 or 3,7,9) in parallel" )
+    and Commandline::describe( "-jobs=N",        "Runs up to N regression workers at once (default: number of cores)" )
+  };
+}
+
+bool Regression::requested()
+{
+  return Commandline::has( "-regress" );
+}
+
+std::vector<uint64_t> Regression::seeds( const std::string& spec )
+{
+  std::vector<uint64_t> result;
+  std::istringstream is{ spec };
+  for( std::string item; std::getline( is, item, ',' ); ) {
+    char* end{ nullptr };
+    uint64_t first = std::strtoull( item.c_str(), &end, 0 );
+    uint64_t last  = first;
+    if( *end == '-' ) {
+      last = std::strtoull( end + 1, &end, 0 );
+    } else if( spec.find_first_of( ",-" ) == std::string::npos ) {
+      first = 1; // Plain count
+    }
+    if( item.empty() or *end != '\0' or last < first ) {
+      REPORT( ERROR, "Unable to interpret seeds " << item << " in -regress=" << spec );
+      continue;
+    }
+    for( auto seed = first; seed <= last; ++seed ) result.push_back( seed );
+  }
+  return result;
+}
+
+void Regression::worker( uint64_t seed, int fd, int (*simulate)() )
+{
+  // Counts inherited from the runner (e.g. earlier seeds) are not this seed's
+  sc_report_handler::initialize();
+  Result result{};
+  result.seed   = seed;
+  result.status = -1;
+  std::error_code ec;
+  auto dir = std::filesystem::path( "regress" ) / ( "seed_" + std::to_string( seed ) );
+  std::filesystem::create_directories( dir, ec );
+  if( not ec ) std::filesystem::current_path( dir, ec );
+  int log = ec ? -1 : ::open( "run.log", O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  if( log >= 0 ) {
+    ::dup2( log, STDOUT_FILENO );
+    ::dup2( log, STDERR_FILENO );
+    ::close( log );
+    Commandline::append( "-seed=" + std::to_string( seed ) );
+    result.status   = simulate();
+    result.infos    = sc_report_handler::get_count( SC_INFO );
+    result.warnings = sc_report_handler::get_count( SC_WARNING );
+    result.errors   = sc_report_handler::get_count( SC_ERROR );
+    result.fatals   = sc_report_handler::get_count( SC_FATAL );
+    result.deltas   = sc_delta_count();
+    std::cout.flush();
+    std::fflush( nullptr );
+  }
+  // Smaller than PIPE_BUF, so written at once and never blocks
+  [[maybe_unused]] auto written = ::write( fd, &result, sizeof( result ) );
+  ::_exit( result.status == 0 ? 0 : 1 );
+}
+
+int Regression::run( int (*simulate)() )
+{
+  auto spec = Commandline::get<std::string>( "-regress", "" );
+  auto list = seeds( spec );
+  auto jobs = Commandline::get<size_t>( "-jobs", std::max( 1u, std::thread::hardware_concurrency() ) );
+  if( list.empty() ) {
+    REPORT( ERROR, "No seeds to run; use e.g. -regress=1-10" );
+    return 1;
+  }
+  if( jobs == 0 ) jobs = 1;
+  INFO( NONE, "Running " << list.size() << " seeds with up to " << jobs << " jobs" );
+
+  // Workers run in their own directories, so files that are read, or
+  // shared by every seed, are named from here
+  const std::pair<const char*,const char*> shared_files[] {
+    { "-stim", "" }, { "-golden", "" }, { "-restore", "checkpoint.bin" }, { "-metrics", "metrics.csv" }
+  };
+  for( const auto& [ option, dflt ] : shared_files ) {
+    auto file = Commandline::get<std::string>( option, dflt );
+    if( not Commandline::has( option ) or file.empty() ) continue;
+    std::error_code ec;
+    auto path = std::filesystem::absolute( file, ec );
+    if( not ec ) Commandline::append( std::string( option ) + "=" + path.string() );
+  }
+
+  struct Running { uint64_t seed; int fd; };
+  std::map<pid_t,Running> running;
+  Result total{};
+  std::vector<uint64_t> failed;
+  size_t next = 0;
+  while( next != list.size() or not running.empty() ) {
+    // Keep every job busy
+    while( running.size() < jobs and next != list.size() ) {
+      auto seed = list[ next++ ];
+      int fds[ 2 ];
+      if( ::pipe( fds ) != 0 ) {
+        REPORT( ERROR, "Unable to create a pipe for seed " << seed );
+        return 1;
+      }
+      std::cout.flush();
+      std::fflush( nullptr ); // Otherwise the worker inherits unwritten output
+      auto pid = ::fork();
+      if( pid == 0 ) {
+        ::close( fds[ 0 ] );
+        worker( seed, fds[ 1 ], simulate );
+      }
+      ::close( fds[ 1 ] );
+      if( pid < 0 ) {
+        ::close( fds[ 0 ] );
+        REPORT( ERROR, "Unable to fork a worker for seed " << seed );
+        return 1;
+      }
+      running[ pid ] = { seed, fds[ 0 ] };
+    }
+    // Collect whichever worker finishes first: its pipe becomes readable
+    // when it sends its result or dies
+    std::vector<pollfd> fds;
+    for( const auto& [ pid, worker ] : running ) fds.push_back( { worker.fd, POLLIN, 0 } );
+    if( ::poll( fds.data(), fds.size(), -1 ) < 0 ) continue; // Interrupted
+    auto elt = std::find_if( running.begin(), running.end(), [&fds]( const auto& entry ) {
+      return std::any_of( fds.begin(), fds.end(), [&entry]( const pollfd& p ) {
+        return p.fd == entry.second.fd and p.revents != 0;
+      } );
+    } );
+    if( elt == running.end() ) continue;
+    Result result{};
+    bool reported = ::read( elt->second.fd, &result, sizeof( result ) ) == ssize_t( sizeof( result ) );
+    ::close( elt->second.fd );
+    int status = 0;
+    ::waitpid( elt->first, &status, 0 );
+    auto seed = elt->second.seed;
+    running.erase( elt );
+    if( not reported or not WIFEXITED( status ) ) {
+      REPORT( WARNING, "Seed " << seed << " died without a result; see regress/seed_" << seed << "/run.log" );
+      failed.push_back( seed );
+      continue;
+    }
+    total.infos    += result.infos;
+    total.warnings += result.warnings;
+    total.errors   += result.errors;
+    total.fatals   += result.fatals;
+    total.deltas   += result.deltas;
+    if( result.status != 0 or result.errors + result.fatals != 0 ) {
+      REPORT( WARNING, "Seed " << seed << " FAILED with " << result.errors << " errors; see regress/seed_" << seed << "/run.log" );
+      failed.push_back( seed );
+    } else {
+      INFO( MEDIUM, "Seed " << seed << " passed" );
+    }
+  }
+
+  std::sort( failed.begin(), failed.end() );
+  std::ostringstream failures;
+  for( size_t i = 0; i != failed.size() and i != 20; ++i ) failures << ' ' << failed[ i ];
+  if( failed.size() > 20 ) failures << " ...";
+  INFO( NONE, "\n" << std::string(80,'#') << "\nRegression summary for " << sc_argv()[0] << ":\n  "
+    << std::setw(2) << list.size()    << " seeds with " << jobs << " jobs" << "\n  "
+    << std::setw(2) << total.infos    << " informational messages" << "\n  "
+    << std::setw(2) << total.warnings << " warnings" << "\n  "
+    << std::setw(2) << total.errors   << " errors"   << "\n  "
+    << std::setw(2) << total.fatals   << " fatals"   << "\n  "
+    << std::setw(2) << total.deltas   << " delta cycles" << "\n  "
+    << std::setw(2) << failed.size()  << " failed seeds" << failures.str() << "\n\n"
+    << "Regression " << (failed.empty()?"PASSED":"FAILED")
+  );
+  return failed.empty() ? 0 : 1;
+}
+
+// TAF!
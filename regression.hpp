@@ -0,0 +1,59 @@
+#pragma once
+
+/** @class Regression
+
+@brief Runs the simulation for many seeds in parallel worker processes
+
+A SystemC simulation can only be elaborated once per process, so with
+`-regress=SEEDS` `sc_main` hands its simulation to `Regression::run()`,
+which forks up to `-jobs=N` workers at a time. Each worker changes to its
+own directory `regress/seed_SEED` (so waveforms and logs do not collide),
+redirects its output to `run.log` there, appends `-seed=SEED` to the
+command-line and runs an independent elaboration and simulation.
+
+Files that are read (`-stim`, `-golden`, `-restore`) or shared by every
+seed (`-metrics`) are made absolute before the workers start, so relative
+names mean the directory the regression was started from. Other outputs
+(e.g. `-stim-capture`, `-checkpoint`) land in each seed's directory.
+
+When a worker finishes it sends its report counts back over a pipe. The
+runner reports each failing seed and ends with a merged summary in the
+style of the normal end-of-run summary. A worker that dies without
+reporting counts as a failure.
+
+SEEDS is a comma-separated list of seeds and inclusive ranges, e.g.
+`1-100` or `3,7,20-29`. A plain count such as `-regress=8` means seeds 1
+to 8.
+
+Usage
+-----
+
+```c++
+if( Regression::requested() ) return Regression::run( simulate );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Regression
+{
+  static bool requested();                   ///< True if -regress was given
+  static int run( int (*simulate)() );       ///< Returns the exit status
+private:
+  struct Result {                            ///< Sent from worker to runner
+    uint64_t seed;
+    int32_t  status;
+    uint32_t infos, warnings, errors, fatals;
+    uint64_t deltas;
+  };
+  static std::vector<uint64_t> seeds( const std::string& spec );
+  [[noreturn]] static void worker( uint64_t seed, int fd, int (*simulate)() );
+  static constexpr const char* const MSGID{ "/Doulos/Example/regression" };
+};
+
+// TAF!
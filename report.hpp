@@ -35,6 +35,17 @@ If your streaming expression (see instructions) contains commas, then
 you must surround that element with parentheses due to limitations of
 pre-processor macros.
 
+Messages longer than Report::capacity characters are truncated.
+
+Formatting
+----------
+
+Messages are formatted into a fixed-capacity buffer taken from a small
+per-thread pool, so the macros do not allocate once the pool exists and a
+message may safely be composed while another is being formatted (e.g. from
+within an operator<<). Message identifiers for the INFO macro are computed
+at compile-time.
+
 Instructions
 ------------
 
@@ -86,58 +97,196 @@ debug:
 % run.x -debug=observer -debug=splitter # debugs only for specified elements
 % run.x -debugall # turns on all DEBUG messages
 
+Each instance resolves whether it is being debugged only once, on its first
+DEBUG message, and caches the answer in the Debug registry. After that the
+cost of a DEBUG statement is the verbosity test plus one table lookup.
+
 ********************************************************************************
 */
 
 #include "systemc.hpp"
-#include <string>
+#include <cstdint>
 #include <iomanip>
-#include <sstream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
 struct Report {
-  inline static std::ostringstream mout;
+  static constexpr size_t capacity{ 1024 }; ///< Longest message (truncated beyond)
+  static constexpr size_t depth{ 4 };       ///< Nesting supported without allocation
+
+  // Formatting stream backed by a fixed-capacity, per-thread buffer. Streams
+  // nest, so a message may be composed while another is being formatted.
+  class Stream {
+  public:
+    Stream()
+    : m_pool( pool() )
+    {
+      if( m_pool.level < depth ) {
+        m_slot = &m_pool.slots[ m_pool.level ];
+      } else {
+        m_extra = std::make_unique<Slot>(); // Only for unusually deep nesting
+        m_slot  = m_extra.get();
+      }
+      ++m_pool.level;
+      m_slot->reset();
+    }
+    ~Stream() { --m_pool.level; }
+    Stream( const Stream& ) = delete;
+    Stream& operator=( const Stream& ) = delete;
+    std::ostream& os() { return m_slot->os; }
+    const char* c_str() { return m_slot->buf.c_str(); }
+  private:
+    class Buffer: public std::streambuf {
+    public:
+      Buffer() { reset(); }
+      void reset() { setp( m_text, m_text + capacity - 1 ); }
+      const char* c_str() { *pptr() = '\0'; return m_text; }
+    protected:
+      int_type overflow( int_type ch ) override { return traits_type::not_eof( ch ); } // Truncate
+    private:
+      char m_text[ capacity ];
+    };
+    struct Slot {
+      Buffer       buf;
+      std::ostream os{ &buf };
+      void reset()
+      {
+        buf.reset();
+        os.clear();
+        os.flags( std::ios_base::dec | std::ios_base::skipws );
+        os.fill( ' ' );
+        os.width( 0 );
+        os.precision( 6 );
+      }
+    };
+    struct Pool {
+      Slot   slots[ depth ];
+      size_t level{ 0 };
+    };
+    static Pool& pool()
+    {
+      thread_local Pool per_thread;
+      return per_thread;
+    }
+    Pool&                 m_pool;
+    Slot*                 m_slot{ nullptr };
+    std::unique_ptr<Slot> m_extra;
+  };
+
+  // Message identifier "DEBUG(basename:line)" computed at compile-time
+  template<size_t N>
+  struct Callsite {
+    char text[ N + 24 ]{};
+    constexpr Callsite( const char (&file)[N], int line )
+    {
+      size_t base = 0;
+      for( size_t i = 0; i < N and file[ i ] != '\0'; ++i ) {
+        if( file[ i ] == '/' ) base = i + 1;
+      }
+      size_t pos = 0;
+      for( auto c : { 'D', 'E', 'B', 'U', 'G', '(' } ) text[ pos++ ] = c;
+      for( size_t i = base; i < N and file[ i ] != '\0'; ++i ) text[ pos++ ] = file[ i ];
+      text[ pos++ ] = ':';
+      char digits[ 12 ]{};
+      size_t ndigits = 0;
+      do {
+        digits[ ndigits++ ] = static_cast<char>( '0' + line % 10 );
+        line /= 10;
+      } while( line > 0 );
+      while( ndigits > 0 ) text[ pos++ ] = digits[ --ndigits ];
+      text[ pos++ ] = ')';
+    }
+    constexpr const char* c_str() const { return text; }
+  };
+
+  // Append " at TIME" once time is meaningful
+  static void append_time( std::ostream& os )
+  {
+    const auto& now = sc_core::sc_time_stamp();
+    if( now > sc_core::SC_ZERO_TIME
+        or sc_core::sc_get_status() >= sc_core::SC_START_OF_SIMULATION ) {
+      os << " at ";
+      put_time( os, now );
+    }
+  }
+
+  // Same text as sc_time::to_string() without the temporary string
+  static void put_time( std::ostream& os, const sc_core::sc_time& t )
+  {
+    static constexpr char const* const units[]{ "fs", "ps", "ns", "us", "ms", "s" };
+    auto val = t.value();
+    if( val == 0 ) {
+      os << "0 s";
+      return;
+    }
+    auto tr = static_cast<uint64_t>( sc_core::sc_get_time_resolution().to_seconds() * 1e15 + 0.5 );
+    int n = 0;
+    while( tr > 0 and tr % 10 == 0 ) { tr /= 10; ++n; }
+    while( val % 10 == 0 ) { val /= 10; ++n; }
+    os << std::dec << val;
+    if( n >= 15 ) {
+      for( ; n > 15; --n ) os << '0';
+      os << " s";
+    } else {
+      for( int z = n % 3; z > 0; --z ) os << '0';
+      os << ' ' << units[ n / 3 ];
+    }
+  }
 };
 
 // For type: WARNING, ERROR, FATAL
 #define REPORT(type,stream)                            \
 do {                                                   \
-  Report::mout << std::dec << stream << std::ends;     \
-  auto str = Report::mout.str(); Report::mout.str(""); \
-  SC_REPORT_##type( MSGID, str.c_str() );              \
+  Report::Stream report_stream_;                       \
+  report_stream_.os() << stream;                       \
+  SC_REPORT_##type( MSGID, report_stream_.c_str() );   \
 } while (0)
 // For level: NONE, LOW, MEDIUM, HIGH, DEBUG
 #define INFO(level,stream)                                                     \
 do {                                                                           \
   if( sc_core::sc_report_handler::get_verbosity_level()                        \
         >= (sc_core::SC_##level) ) {                                           \
-    Report::mout << std::dec << stream;                                        \
-    auto now = sc_core::sc_time_stamp();                                       \
-    if( now > sc_core::SC_ZERO_TIME                                            \
-        or sc_core::sc_get_status() >= sc_core::SC_START_OF_SIMULATION ) {     \
-      Report::mout << std::dec << " at " << now;                               \
-    }                                                                          \
-    Report::mout << std::ends;                                                 \
+    Report::Stream report_stream_;                                             \
+    report_stream_.os() << stream;                                             \
+    Report::append_time( report_stream_.os() );                                \
     if( (sc_core::SC_##level) > sc_core::SC_DEBUG ) {                          \
-      std::string id{"DEBUG("};                                                \
-      id+=__FILE__ ; id+=":"; id+=std::to_string(__LINE__)+")";                \
-      size_t p0=id.find("/"),p1=id.find_last_of("/");                          \
-      if(p1!=std::string::npos) id.erase(p0,p1-p0+1);                          \
-      auto str = Report::mout.str(); Report::mout.str("");                     \
-      SC_REPORT_INFO_VERB( id.c_str(), str.c_str(), (sc_core::SC_##level) );   \
+      static constexpr Report::Callsite report_id_{ __FILE__, __LINE__ };      \
+      SC_REPORT_INFO_VERB( report_id_.c_str(), report_stream_.c_str()          \
+                         , (sc_core::SC_##level) );                            \
     } else {                                                                   \
-      auto str = Report::mout.str(); Report::mout.str("");                     \
-      SC_REPORT_INFO_VERB( MSGID, str.c_str(), (sc_core::SC_##level) );        \
+      SC_REPORT_INFO_VERB( MSGID, report_stream_.c_str()                       \
+                         , (sc_core::SC_##level) );                            \
     }                                                                          \
   }                                                                            \
 } while (0)
 
 #ifdef NDEBUG
-#define DEBUG()
+#define DEBUG(stream)
 #else
 #include "commandline.hpp"
+#include <unordered_map>
+// Per-instance cache of -debug=INSTANCE and -debugall
+struct Debug {
+  // Return true if DEBUG messages are enabled for the specified object
+  static bool enabled( const sc_core::sc_object* obj )
+  {
+    static const bool debug_all{ Commandline::has_opt( "-debugall" ) != 0 };
+    if( debug_all ) return true;
+    auto [ elt, inserted ] = s_enabled.try_emplace( obj, false );
+    if( inserted ) {
+      std::string opt{ "-debug=" };
+      opt += obj->basename();
+      elt->second = Commandline::has_opt( opt ) != 0;
+    }
+    return elt->second;
+  }
+private:
+  inline static std::unordered_map<const sc_core::sc_object*,bool> s_enabled;
+};
 #define DEBUG(stream) do {                                                     \
   if( sc_core::sc_report_handler::get_verbosity_level() >= sc_core::SC_DEBUG   \
-  and ( Commandline::has_opt("-debugall")                                      \
-     or Commandline::has_opt("-debug="s + basename() ) ) ) {                   \
+  and Debug::enabled( this ) ) {                                               \
      INFO(DEBUG,stream);                                                       \
   }                                                                            \
 } while(0)
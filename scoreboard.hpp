@@ -0,0 +1,255 @@
+#pragma once
+
+/** @class Scoreboard
+
+@brief Bounded store of expectations matched against actual results
+
+Expectations live in a ring of fixed capacity allocated up front, so memory
+stays bounded however long the design under test stalls. When the ring is
+full, `nb_put()` fails and `put()` waits for room (backpressure).
+
+Matching is in order by default: each actual result is compared with the
+oldest expectation. In out-of-order mode, an actual result is matched with
+the oldest expectation of equal value, found through a preallocated
+open-addressing hash index, so reordering designs can be verified. `Hash`
+defaults to `std::hash<T>`; wide payloads use `Payload<T>::Hash`.
+
+The scoreboard tracks the latency from expectation to match, the peak
+occupancy and, at the end, any orphaned expectations. Call `report()` from
+`end_of_simulation()`. The statistics are shown at `MEDIUM` verbosity, or
+at `HIGH` for one of many instances (e.g. with `-lanes=K`). `save()` and
+`load()` carry the outstanding expectations and the statistics across a
+checkpoint.
+
+Usage
+-----
+
+```c++
+Scoreboard<Data_t> scoreboard{ 1024, out_of_order };
+scoreboard.nb_put( expected );
+...
+if( auto m = scoreboard.match( actual ); not m.found ) ...unexpected...
+else if( m.expected != actual ) ...mismatch...
+```
+
+Note: a single expectation that is never matched holds back the ring in
+out-of-order mode, which eventually shows up as backpressure.
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "report.hpp"
+#include "profile.hpp"
+#include "checkpoint.hpp"
+#include "payload.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <vector>
+
+template<typename T, typename Hash = std::hash<T>>
+class Scoreboard
+{
+public:
+  struct Match {
+    bool found;
+    T    expected;
+  };
+
+  Scoreboard( size_t capacity, bool out_of_order = false )
+  : m_slots( capacity )
+  , m_out_of_order( out_of_order )
+  {
+    sc_assert( capacity > 0 );
+    if( m_out_of_order ) {
+      size_t n = 2;
+      while( n < 2 * capacity ) n <<= 1; // Keeps the load at most one half
+      m_table.assign( n, empty_entry );
+    }
+  }
+
+  bool nb_put( const T& expected ) ///< Returns false if full
+  {
+    if( m_tail - m_head == m_slots.size() ) return false;
+    auto& slot = m_slots[ m_tail % m_slots.size() ];
+    slot.value = expected;
+    slot.when  = sc_core::sc_time_stamp();
+    slot.live  = true;
+    if( m_out_of_order ) insert( m_tail );
+    ++m_tail;
+    m_peak = std::max( m_peak, ++m_live );
+    m_put_event.notify( sc_core::SC_ZERO_TIME );
+    return true;
+  }
+  void put( const T& expected ) ///< Waits for room
+  {
+    while( not nb_put( expected ) ) Profile::wait( m_match_event );
+  }
+  bool   empty() const { return m_live == 0; }
+  size_t size() const { return m_live; }
+  size_t capacity() const { return m_slots.size(); }
+  const sc_core::sc_event& ok_to_get() const { return m_put_event; }   ///< Expectation added
+  const sc_core::sc_event& ok_to_put() const { return m_match_event; } ///< Expectation removed
+
+  Match match( const T& actual ) ///< Remove the corresponding expectation
+  {
+    uint64_t seq = m_head;
+    if( m_out_of_order ) {
+      if( not find( actual, seq ) ) return { false, T{} };
+    } else if( empty() ) {
+      return { false, T{} };
+    }
+    auto& slot = m_slots[ seq % m_slots.size() ];
+    record( sc_core::sc_time_stamp() - slot.when );
+    slot.live = false;
+    --m_live;
+    while( m_head != m_tail and not m_slots[ m_head % m_slots.size() ].live ) ++m_head;
+    if( m_tombs > m_table.size() / 4 ) rehash();
+    m_match_event.notify( sc_core::SC_ZERO_TIME );
+    return { true, slot.value };
+  }
+
+  void report( const char* name, bool one_of_many = false ) const ///< Statistics and orphans
+  {
+    using namespace sc_core;
+    if( sc_report_handler::get_verbosity_level() >= ( one_of_many ? SC_HIGH : SC_MEDIUM ) ) {
+      INFO( MEDIUM, name << " peak occupancy " << m_peak << " of " << m_slots.size()
+                    << ( m_out_of_order ? " (out-of-order)" : "" ) );
+      if( m_matched != 0 ) {
+        INFO( MEDIUM, name << " matched " << m_matched << " with latency up to " << m_max_latency );
+        for( size_t b = 0; b != m_histogram.size(); ++b ) {
+          if( m_histogram[ b ] == 0 ) continue;
+          INFO( MEDIUM, name << " latency < " << ( uint64_t( 1 ) << b ) << " ns: " << m_histogram[ b ] );
+        }
+      }
+    }
+    if( m_live != 0 ) {
+      REPORT( WARNING, name << " has " << m_live << " orphaned expectation(s)" );
+      size_t shown = 0;
+      for( auto seq = m_head; seq != m_tail and shown != max_orphans; ++seq ) {
+        const auto& slot = m_slots[ seq % m_slots.size() ];
+        if( not slot.live ) continue;
+        INFO( MEDIUM, name << " orphan 0x" << std::hex << printable( slot.value ) << std::dec
+                      << " expected since " << slot.when );
+        ++shown;
+      }
+    }
+  }
+
+  void save( Checkpoint::Writer& out ) const ///< Outstanding expectations and statistics
+  {
+    out.put( uint64_t( m_live ) );
+    for( auto seq = m_head; seq != m_tail; ++seq ) {
+      const auto& slot = m_slots[ seq % m_slots.size() ];
+      if( not slot.live ) continue;
+      out.put( slot.value );
+      out.put( slot.when );
+    }
+    out.put( m_peak );
+    out.put( m_matched );
+    out.put( m_max_latency );
+    out.put( m_histogram );
+  }
+  void load( Checkpoint::Reader& in ) ///< Replaces the contents; before simulation
+  {
+    uint64_t live{ 0 };
+    in.get( live );
+    for( auto& slot : m_slots ) slot.live = false;
+    m_head = m_tail = 0;
+    m_live = 0;
+    for( uint64_t i = 0; i != live and in.ok(); ++i ) {
+      Slot slot;
+      in.get( slot.value );
+      in.get( slot.when );
+      slot.live = true;
+      if( m_tail - m_head == m_slots.size() ) {
+        REPORT( ERROR, "Checkpoint holds more than " << m_slots.size() << " expectations (see -scoreboard=N)" );
+        continue;
+      }
+      m_slots[ m_tail++ % m_slots.size() ] = slot;
+      ++m_live;
+    }
+    if( m_out_of_order ) rehash();
+    in.get( m_peak );
+    in.get( m_matched );
+    in.get( m_max_latency );
+    in.get( m_histogram );
+  }
+
+private:
+  static constexpr const char* const MSGID{ "/Doulos/Scoreboard" };
+  static constexpr size_t   max_orphans{ 10 };
+  static constexpr uint64_t empty_entry{ 0 };
+  static constexpr uint64_t tomb_entry{ ~uint64_t( 0 ) };
+  struct Slot {
+    T                value{};
+    sc_core::sc_time when;
+    bool             live{ false };
+  };
+
+  // Hash index holds sequence numbers plus one
+  size_t home( const T& value ) const { return Hash{}( value ) & ( m_table.size() - 1 ); }
+  void insert( uint64_t seq )
+  {
+    for( auto i = home( m_slots[ seq % m_slots.size() ].value );; i = ( i + 1 ) & ( m_table.size() - 1 ) ) {
+      if( m_table[ i ] == tomb_entry ) --m_tombs;
+      if( m_table[ i ] == empty_entry or m_table[ i ] == tomb_entry ) {
+        m_table[ i ] = seq + 1;
+        return;
+      }
+    }
+  }
+  bool find( const T& actual, uint64_t& seq ) ///< Oldest expectation equal to actual
+  {
+    size_t found = m_table.size();
+    for( auto i = home( actual ); m_table[ i ] != empty_entry; i = ( i + 1 ) & ( m_table.size() - 1 ) ) {
+      if( m_table[ i ] == tomb_entry ) continue;
+      auto candidate = m_table[ i ] - 1;
+      if( m_slots[ candidate % m_slots.size() ].value == actual
+        and ( found == m_table.size() or candidate < seq ) ) {
+        found = i;
+        seq   = candidate;
+      }
+    }
+    if( found == m_table.size() ) return false;
+    m_table[ found ] = tomb_entry;
+    ++m_tombs;
+    return true;
+  }
+  void rehash()
+  {
+    std::fill( m_table.begin(), m_table.end(), empty_entry );
+    m_tombs = 0;
+    for( auto seq = m_head; seq != m_tail; ++seq ) {
+      if( m_slots[ seq % m_slots.size() ].live ) insert( seq );
+    }
+  }
+  void record( const sc_core::sc_time& latency )
+  {
+    ++m_matched;
+    m_max_latency = std::max( m_max_latency, latency );
+    auto ns = latency.to_seconds() * 1e9;
+    size_t b = 0;
+    while( b + 1 != m_histogram.size() and ns >= double( uint64_t( 1 ) << b ) ) ++b;
+    ++m_histogram[ b ];
+  }
+
+  std::vector<Slot>     m_slots;
+  std::vector<uint64_t> m_table; ///< Out-of-order index
+  bool                  m_out_of_order;
+  uint64_t              m_head{ 0 }; ///< Oldest slot in use
+  uint64_t              m_tail{ 0 }; ///< Next slot
+  size_t                m_live{ 0 };
+  size_t                m_tombs{ 0 };
+  size_t                m_peak{ 0 };
+  size_t                m_matched{ 0 };
+  sc_core::sc_time      m_max_latency;
+  std::array<size_t,32> m_histogram{}; ///< Bucket b counts latencies below 2^b ns
+  sc_core::sc_event     m_put_event;
+  sc_core::sc_event     m_match_event;
+};
+
+// TAF!
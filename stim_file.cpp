@@ -0,0 +1,139 @@
+#include "stim_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sc_core;
+
+namespace {
+  constexpr size_t block_samples{ 65536 }; // Written at once when capturing, shared by all writers
+  constexpr size_t min_block{ 256 };       // Per writer however many share
+
+  uint64_t resolution_fs()
+  {
+    return static_cast<uint64_t>( sc_get_time_resolution().to_seconds() * 1e15 + 0.5 );
+  }
+}
+
+Stim_reader::~Stim_reader()
+{
+  if( m_map != nullptr ) ::munmap( m_map, m_bytes );
+}
+
+bool Stim_reader::open( const std::string& filename, size_t sample_bytes )
+{
+  sc_assert( m_map == nullptr and sample_bytes != 0 );
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  struct stat st{};
+  if( fd < 0 or ::fstat( fd, &st ) != 0 ) {
+    if( fd >= 0 ) ::close( fd );
+    REPORT( ERROR, "Unable to open stimulus file " << filename );
+    return false;
+  }
+  m_bytes = size_t( st.st_size );
+  if( m_bytes != 0 ) {
+    m_map = ::mmap( nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0 );
+  }
+  ::close( fd ); // The mapping keeps the file open
+  if( m_map == MAP_FAILED ) {
+    m_map = nullptr;
+    REPORT( ERROR, "Unable to map stimulus file " << filename );
+    return false;
+  }
+  if( m_map == nullptr ) return true; // Empty
+  ::madvise( m_map, m_bytes, MADV_SEQUENTIAL );
+
+  const auto bytes = static_cast<const unsigned char*>( m_map );
+  Stim_format::File_header header{};
+  if( m_bytes >= sizeof( header ) ) std::memcpy( &header, bytes, sizeof( header ) );
+  if( std::memcmp( header.magic, Stim_format::magic, sizeof( header.magic ) ) != 0 ) {
+    // Raw samples
+    m_samples = bytes;
+    m_stride  = sample_bytes;
+    m_size    = m_bytes / sample_bytes;
+    if( m_bytes % sample_bytes != 0 ) {
+      REPORT( WARNING, "Ignoring a partial sample at the end of " << filename );
+    }
+    return true;
+  }
+  if( header.sample_bytes != sample_bytes or header.resolution_fs == 0 ) {
+    REPORT( ERROR, "Stimulus file " << filename << " has " << header.sample_bytes
+                   << "-byte samples; expected " << sample_bytes << " (see -payload)" );
+    return false;
+  }
+  m_samples = bytes + sizeof( header ) + sizeof( uint64_t );
+  m_stride  = Stim_format::record_bytes( sample_bytes );
+  m_size    = ( m_bytes - sizeof( header ) ) / m_stride;
+  m_timed   = true;
+  m_tick    = double( header.resolution_fs ) * 1e-15;
+  m_native  = header.resolution_fs == resolution_fs();
+  return true;
+}
+
+sc_time Stim_reader::time( size_t i ) const
+{
+  sc_assert( m_timed and i < m_size );
+  uint64_t ticks;
+  std::memcpy( &ticks, sample( i ) - sizeof( ticks ), sizeof( ticks ) );
+  if( m_native ) return sc_time::from_value( ticks );
+  return sc_time( double( ticks ) * m_tick, SC_SEC );
+}
+
+bool Stim_writer::open( const std::string& filename, size_t sample_bytes )
+{
+  sc_assert( not m_open and sample_bytes != 0 );
+  auto fp = std::fopen( filename.c_str(), "wb" );
+  if( fp == nullptr ) {
+    REPORT( ERROR, "Unable to create stimulus file " << filename );
+    return false;
+  }
+  Stim_format::File_header header{};
+  std::memcpy( header.magic, Stim_format::magic, sizeof( header.magic ) );
+  header.resolution_fs = resolution_fs();
+  header.sample_bytes  = uint32_t( sample_bytes );
+  bool written = std::fwrite( &header, sizeof( header ), 1, fp ) == 1;
+  if( std::fclose( fp ) != 0 or not written ) {
+    REPORT( ERROR, "Unable to write stimulus file " << filename );
+    return false;
+  }
+  m_filename = filename;
+  m_open     = true;
+  m_record   = Stim_format::record_bytes( sample_bytes );
+  ++s_writers;
+  return true;
+}
+
+// At the first sample, once elaboration has opened every writer
+void Stim_writer::allocate()
+{
+  m_buffer.assign( std::max( block_samples / s_writers, min_block ) * m_record, 0 );
+}
+
+// Reopened for each block, so thousands of lanes do not hold thousands of files
+void Stim_writer::flush()
+{
+  if( m_used == 0 ) return;
+  auto fp = std::fopen( m_filename.c_str(), "ab" );
+  bool written = fp != nullptr and std::fwrite( m_buffer.data(), 1, m_used, fp ) == m_used;
+  if( fp == nullptr or std::fclose( fp ) != 0 or not written ) {
+    REPORT( ERROR, "Unable to append to stimulus file " << m_filename << " (disk full?)" );
+    m_open = false;
+    --s_writers;
+  } else {
+    m_count += m_used / m_record;
+  }
+  m_used = 0;
+}
+
+void Stim_writer::close()
+{
+  if( not m_open ) return;
+  flush();
+  m_open = false;
+  --s_writers;
+}
+
+// TAF!
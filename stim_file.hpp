@@ -0,0 +1,152 @@
+#pragma once
+
+/** @file stim_file.hpp
+
+@brief Memory-mapped stimulus files for replay and capture
+
+`Stim_reader` maps a file of samples into memory, so replaying it costs no
+file I/O or parsing per sample; the kernel pages the samples in as they
+are read. `Stim_writer` records samples in the same format, buffered and
+appended in large blocks; the file is only open while a block is written.
+
+A file is either:
+
+- a `Stim_format::File_header` followed by one record per sample: the
+  time it was sent (`uint64_t`), then the sample as stored by
+  `Payload<T>::store()`, padded to a multiple of 8 bytes; or
+- raw samples of `Payload<T>::bytes` each with no header, e.g. converted
+  production traffic, which are sent at the regular sample period.
+
+Bursts (`-burst`, `-quantum`) are always annotated with the regular period.
+
+The observer uses the same format for golden results (`-golden-capture`
+and `-golden`), with the time each result was due.
+
+With `-lanes=K`, each lane reads and writes its own file, named by
+`Top_module::lane_file()` (e.g. run.lane_3.stim). Writers open at the first
+`append()` (e.g. a stimulus and a golden capture per lane) share one
+block, so memory does not grow with K.
+
+Integers are in the byte order of the host. Times are in ticks of
+`resolution_fs` femtoseconds.
+
+Usage
+-----
+
+```c++
+Stim_reader replay;
+if( replay.open( "traffic.stim", Payload<T>::bytes ) ) {
+  for( size_t i = 0; i != replay.size(); ++i ) send( replay.value<T>( i ), replay.time( i ) );
+}
+
+Stim_writer capture;
+capture.open( "run.stim", Payload<T>::bytes );
+capture.append( sc_time_stamp(), value );
+capture.close();                  // Also on destruction
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "common.hpp"
+#include "payload.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Stim_format {
+
+  constexpr char magic[ 8 ]{ 'S', 'C', 'S', 'T', 'I', 'M', '1', '\0' };
+
+  struct File_header {
+    char     magic[ 8 ];
+    uint64_t resolution_fs; ///< Femtoseconds per time tick
+    uint32_t sample_bytes;  ///< Payload<T>::bytes when written
+    uint32_t reserved;
+  };
+
+  constexpr size_t record_bytes( size_t sample_bytes ) ///< Time and padded sample
+  {
+    return sizeof( uint64_t ) + ( sample_bytes + 7 ) / 8 * 8;
+  }
+
+  static_assert( sizeof( File_header ) == 24 );
+
+}
+
+class Stim_reader
+{
+public:
+  Stim_reader() = default;
+  ~Stim_reader();
+  Stim_reader( const Stim_reader& ) = delete;
+  Stim_reader& operator=( const Stim_reader& ) = delete;
+  bool open( const std::string& filename, size_t sample_bytes ); ///< Reports and returns false on failure
+  size_t size() const { return m_size; }
+  bool   timed() const { return m_timed; }
+  const unsigned char* sample( size_t i ) const { return m_samples + i * m_stride; }
+  template<typename T>
+  T value( size_t i ) const
+  {
+    T result;
+    Payload<T>::load( sample( i ), result );
+    return result;
+  }
+  template<typename T>
+  void copy( size_t i, T* out, size_t n ) const ///< Samples i..i+n-1
+  {
+    sc_assert( i + n <= m_size );
+    for( size_t j = 0; j != n; ++j ) Payload<T>::load( sample( i + j ), out[ j ] );
+  }
+  sc_core::sc_time time( size_t i ) const; ///< When sample i is due (timed files only)
+private:
+  void*                m_map{ nullptr };
+  size_t               m_bytes{ 0 };
+  size_t               m_size{ 0 };
+  const unsigned char* m_samples{ nullptr };
+  size_t               m_stride{ 0 };      ///< Bytes from one sample to the next
+  bool                 m_timed{ false };
+  double               m_tick{ 0 };        ///< Seconds per tick
+  bool                 m_native{ true };   ///< Same resolution as the simulator
+  static constexpr const char* const MSGID{ "/Doulos/Example/stim_file" };
+};
+
+class Stim_writer
+{
+public:
+  Stim_writer() = default;
+  ~Stim_writer() { close(); }
+  Stim_writer( const Stim_writer& ) = delete;
+  Stim_writer& operator=( const Stim_writer& ) = delete;
+  bool open( const std::string& filename, size_t sample_bytes ); ///< Reports and returns false on failure
+  template<typename T>
+  void append( const sc_core::sc_time& time, const T& value )
+  {
+    if( not m_open ) return;
+    if( m_buffer.empty() ) allocate();
+    auto record = m_buffer.data() + m_used;
+    uint64_t ticks = time.value();
+    std::memcpy( record, &ticks, sizeof( ticks ) );
+    Payload<T>::store( value, record + sizeof( ticks ) );
+    m_used += m_record;
+    if( m_used == m_buffer.size() ) flush();
+  }
+  void close();
+  size_t size() const { return m_count; }
+private:
+  void allocate();
+  void flush();
+  std::string                        m_filename;
+  bool                               m_open{ false };
+  std::vector<unsigned char>         m_buffer;   ///< Whole records, zero padded
+  size_t                             m_record{ 0 };
+  size_t                             m_used{ 0 };
+  size_t                             m_count{ 0 };
+  inline static size_t               s_writers{ 0 }; ///< Open at once
+  static constexpr const char* const MSGID{ "/Doulos/Example/stim_file" };
+};
+
+// TAF!
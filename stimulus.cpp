@@ -1,73 +1,212 @@
 #include "stimulus.hpp"
 #include "top.hpp"
 #include "objection.hpp"
-#include <random>
+#include "checkpoint.hpp"
+#include "metrics.hpp"
+#include "commandline.hpp"
+#include "tlm.hpp"
+#include <tlm_utils/tlm_quantumkeeper.h>
+#include <algorithm>
 
 using namespace sc_core;
 
 namespace {
   constexpr char const* const MSGID{ "/Doulos/Example/tracing" };
+  constexpr size_t draw_block{ 64 }; // Samples drawn at once (whole 64-bit draws)
+  [[maybe_unused]] const bool described {
+        Commandline::describe( "-n=SAMPLE_SIZE", "Number of samples to generate (default 10)" )
+    and Commandline::describe( "-burst=N",       "Transfer samples in bursts of N (default 1)" )
+    and Commandline::describe( "-stim=FILE",     "Replays samples from FILE (captured or raw payloads) instead of random ones" )
+    and Commandline::describe( "-stim-capture=FILE", "Records the samples sent, with their times, to FILE (one per lane) for -stim" )
+  };
 }
 
-Stimulus_module::Stimulus_module( sc_module_name instance )
-  : sc_module( instance )
+template<typename T>
+Stimulus_module<T>::Stimulus_module( sc_module_name instance )
+  : Profiled_module( instance )
+  , rng( name() )
 {
   SC_HAS_PROCESS( Stimulus_module );
   SC_THREAD( stimulus_thread );
   stim_export.bind( stimulus );
+  burst_export.bind( bursts );
   running_export.bind( running );
+
+  // Determine sample size
+  sample_size = Commandline::get<int>( "-n", sample_size );
+  if ( sample_size < 1 ) {
+    REPORT( WARNING, "Sample size (-n) should be a number 1..100" );
+    sample_size = 1;
+  }
+  burst_size = Commandline::get<size_t>( "-burst", 1 );
+  if( burst_size <= 1 ) burst_size = 0;
+  loosely_timed = Commandline::has( "-quantum" );
+
+  // Replay and capture
+  if ( Commandline::has( "-stim" ) ) {
+    auto filename = Top_module::lane_file( Commandline::get<std::string>( "-stim", "" ), this );
+    replaying = replay.open( filename, Payload<T>::bytes );
+    if ( replaying and ( not Commandline::has( "-n" ) or size_t( sample_size ) > replay.size() ) ) {
+      sample_size = int( replay.size() ); // -n may send fewer
+    }
+    if ( replaying ) {
+      INFO( MEDIUM, "Replaying " << sample_size << " samples from " << filename
+                    << ( replay.timed() and burst_size == 0 and not loosely_timed
+                       ? " at their recorded times" : "" ) );
+    }
+  }
+  if ( Commandline::has( "-stim-capture" ) ) {
+    capture.open( Top_module::lane_file( Commandline::get<std::string>( "-stim-capture", "capture.stim" ), this )
+                , Payload<T>::bytes );
+  }
+  remaining = uint64_t( sample_size );
+
+  // Taken between samples, so the one about to be sent is part of the state
+  Checkpoint::add( this
+  , [this]( Checkpoint::Writer& out ) {
+      out.put( rng );
+      out.put( remaining );
+      out.put( test_count );
+      out.put( value );
+      out.put( burst );
+      out.put( drawn );
+      out.put( drawn_next );
+    }
+  , [this]( Checkpoint::Reader& in ) {
+      in.get( rng );
+      in.get( remaining );
+      in.get( test_count );
+      in.get( value );
+      in.get( burst );
+      in.get( drawn );
+      in.get( drawn_next );
+      resumed = true;
+    } );
 }
 
-void Stimulus_module::start_of_simulation()
+template<typename T>
+void Stimulus_module<T>::start_of_simulation()
 {
   const auto& trace_file { Top_module::trace_file() };
 
   if ( trace_file != nullptr ) {
     auto prefix = std::string( name() ) + ".";
-    sc_trace( trace_file, running, prefix + "running" );
-    sc_trace( trace_file, test_count, prefix + "test_count" );
-    sc_trace( trace_file, value, prefix + "value" );
+    Top_module::trace( running, prefix + "running" );
+    Top_module::trace( test_count, prefix + "test_count" );
+    Top_module::trace( value, prefix + "value" );
   }
 
   Objection::set_drain_time( 2_ns );
 }
 
-void Stimulus_module::stimulus_thread()
+template<typename T>
+void Stimulus_module<T>::stimulus_thread()
 {
   INFO( NONE, "Starting " << __PRETTY_FUNCTION__ );
 
-  // Determine sample size
-  auto sample_size = 10; // Default
-
-  if ( int i = Commandline::has_opt( "-n=" ); i != 0 ) {
-    std::string arg = sc_argv()[ i ];
-    sample_size = std::stoi( arg.substr( 3 ) );
+  INFO( NONE, "Generating " << remaining << " samples." );
 
-    if ( sample_size <= 1 ) {
-      REPORT( WARNING, "Sample size (-n) should be a number 1..100" );
-      sample_size = 1;
-    }
-  }
-
-  INFO( NONE, "Generating " << sample_size << " samples." );
-
-  static std::default_random_engine    gen;
-  static std::uniform_int_distribution dist( 0, ~value );
+  const auto period = 10_ns; // Between samples
 
   // Generate samples
   running.write( true );
-  Objection o{ "Stimulus" };
-
-  while ( sample_size-- ) {
-    value = dist( gen );
-    wait( 10_ns );
-    DEBUG( "Sending 0x" << std::hex << value );
-    ++test_count;
-    stimulus.write( value );
+  Objection o{ "Stimulus", this };
+  if ( resumed ) {
+    wait( Checkpoint::time() ); // Nothing else happens before then
+  }
+
+  if ( burst_size == 0 and not loosely_timed ) {
+    for ( ; remaining != 0; --remaining ) {
+      if ( resumed ) {
+        resumed = false; // value was drawn before the checkpoint
+      } else {
+        const auto index = uint64_t( sample_size ) - remaining;
+        value = replaying ? replay.template value<T>( index ) : draw();
+        if ( replaying and replay.timed() ) {
+          wait( std::max( replay.time( index ), sc_time_stamp() ) - sc_time_stamp() );
+        } else {
+          wait( period );
+        }
+        checkpoint();
+      }
+      DEBUG( "Sending 0x" << std::hex << printable( value ) );
+      ++test_count;
+      Metrics::sent( 1 );
+      while ( not stimulus.nb_write( value ) ) wait( stimulus.data_read_event() ); // Profiled
+      capture.append( sc_time_stamp(), value );
+    }
+  } else {
+    // One transaction per burst, annotated with the time of each sample.
+    // Loosely-timed bursts end whenever the quantum is used up.
+    tlm_utils::tlm_quantumkeeper qk;
+    qk.reset();
+    size_t limit = burst_size;
+    if ( loosely_timed ) {
+      auto per_quantum = size_t( tlm_utils::tlm_quantumkeeper::get_global_quantum() / period ) + 1;
+      limit = burst_size == 0 ? per_quantum : std::min( burst_size, per_quantum );
+    }
+    while ( remaining != 0 or resumed ) {
+      if ( resumed ) {
+        resumed = false; // burst was filled before the checkpoint
+      } else {
+        // Only samples actually sent are drawn, so a seed gives the same
+        // stimulus with or without -burst and -quantum
+        burst = Burst<T>{ size_t( std::min<uint64_t>( remaining, limit ) ) };
+        burst.set_timing( qk.get_current_time() + period, period );
+        do {
+          const auto index = uint64_t( sample_size ) - remaining;
+          value = replaying ? replay.template value<T>( index ) : draw();
+          burst.push_back( value );
+          qk.inc( period );
+        } while ( --remaining != 0 and burst.size() != limit
+                  and not ( loosely_timed and qk.need_sync() ) );
+        qk.sync();
+        checkpoint();
+      }
+      DEBUG( "Sending " << burst );
+      test_count += burst.size();
+      Metrics::sent( burst.size() );
+      while ( not bursts.nb_write( burst ) ) wait( bursts.data_read_event() ); // Profiled
+      for ( size_t i = 0; i != burst.size(); ++i ) capture.append( burst.time_of( i ), burst[ i ] );
+    }
   }
 
   INFO( NONE, "Stimulus sent " << test_count <<  " samples" );
+  if ( Commandline::has( "-stim-capture" ) ) {
+    capture.close();
+    INFO( MEDIUM, "Captured " << capture.size() << " samples" );
+  }
   running.write( false );
 }
 
+// Samples are drawn a block at a time; any left over go to the next burst
+template<typename T>
+T Stimulus_module<T>::draw()
+{
+  if ( drawn_next == drawn.size() ) {
+    drawn.resize( draw_block );
+    Payload<T>::fill( rng, drawn.data(), drawn.size() );
+    drawn_next = 0;
+  }
+  return drawn[ drawn_next++ ];
+}
+
+// The previous sample (or burst) has had a whole period to pass through
+template<typename T>
+void Stimulus_module<T>::checkpoint()
+{
+  const auto sent = uint64_t( sample_size ) - remaining - burst.size();
+  if ( Checkpoint::due( sent ) ) {
+    Checkpoint::save( sent );
+  }
+}
+
+// One instantiation per Payload_registry::List entry
+template struct Stimulus_module<uint16_t>;
+template struct Stimulus_module<uint8_t>;
+template struct Stimulus_module<uint32_t>;
+template struct Stimulus_module<uint64_t>;
+template struct Stimulus_module<sc_dt::sc_bv<512>>;
+template struct Stimulus_module<sc_dt::sc_biguint<512>>;
+
 // TAF!
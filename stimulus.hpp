@@ -2,18 +2,41 @@
 
 #include "systemc.hpp"
 #include "common.hpp"
+#include "burst.hpp"
+#include "random.hpp"
+#include "profile.hpp"
+#include "stim_file.hpp"
+#include "payload.hpp"
+#include <vector>
 
-struct Stimulus_module : sc_core::sc_module
+template<typename T>
+struct Stimulus_module : Profiled_module
 {
-  sc_core::sc_export<sc_core::sc_fifo_in_if<Data_t>> stim_export    { "stim_export" };
+  sc_core::sc_export<sc_core::sc_fifo_in_if<T>>        stim_export    { "stim_export" };
+  sc_core::sc_export<sc_core::sc_fifo_in_if<Burst<T>>> burst_export   { "burst_export" };
   sc_core::sc_export<sc_core::sc_signal_in_if<bool>> running_export { "running_export" };
   Stimulus_module( sc_core::sc_module_name instance );
   void start_of_simulation();
   void stimulus_thread();
 private:
-  sc_core::sc_fifo<Data_t> stimulus{ 4 };
+  int    sample_size{ 10 }; // -n
+  size_t burst_size{ 0 };   // -burst (0 sends individual samples)
+  bool   loosely_timed{ false }; // -quantum
+  sc_core::sc_fifo<T> stimulus{ 4 };
+  sc_core::sc_fifo<Burst<T>> bursts{ 2 };
   sc_core::sc_signal<bool> running;
+  void checkpoint();           // Saves state if due
+  Random rng;                  // Stream for this instance
+  T draw();                    // Next random sample, the same in every mode
+  std::vector<T> drawn;        // Block of samples drawn at once
+  size_t drawn_next{ 0 };      // Next unused sample in drawn
+  Burst<T> burst;              // Being sent
+  uint64_t remaining{ 0 };     // Samples still to send
+  bool resumed{ false };       // Restored from a checkpoint
+  bool replaying{ false };     // -stim
+  Stim_reader replay;          // Samples to send instead of random ones
+  Stim_writer capture;         // -stim-capture
   // Following are here only for tracing purposes
-  uint16_t test_count{ 0 };
-  Data_t   value{0};
+  uint64_t test_count{ 0 };
+  T        value{};
 };
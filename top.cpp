@@ -5,43 +5,172 @@
 #include "behavior.hpp"
 #include "observer.hpp"
 #include "commandline.hpp"
+#include "log_sink.hpp"
+#include "wave_trace.hpp"
+#include "payload.hpp"
+#include "kernel.hpp"
+#include "tlm.hpp"
+#include <tlm_utils/tlm_quantumkeeper.h>
 
 using namespace sc_core;
 
+namespace {
+  constexpr char const* const MSGID{ "/Doulos/Example/top" };
+  [[maybe_unused]] const bool described {
+        Commandline::describe( "-debug",          "Increases verbosity to debug level (noisy)" )
+    and Commandline::describe( "-debug=INSTANCE", "Debug messages for instances named INSTANCE" )
+    and Commandline::describe( "-debugall",       "Debug messages for all instances" )
+    and Commandline::describe( "-quiet",          "Decreases verbosity lowest level" )
+    and Commandline::describe( "-verbose",        "Increases verbosity to high level" )
+    and Commandline::describe( "-trace",          "Enables output of waveform data to dump.vcd" )
+    and Commandline::describe( "-trace=FORMAT",   "Waveform FORMAT: vcd (default) or bin (compact dump.wave; see wave2vcd.x)" )
+    and Commandline::describe( "-trace=GLOB",     "Traces only signals matching GLOB (e.g. top.observer.*); may be repeated" )
+    and Commandline::describe( "-trace-from=TIME","Starts recording waveforms at TIME (bin format)" )
+    and Commandline::describe( "-trace-to=TIME",  "Stops recording waveforms after TIME (bin format)" )
+    and Commandline::describe( "-trace-trigger=TIME", "Records waveforms only from TIME before the first failure (bin format)" )
+    and Commandline::describe( "-log=FILE",       "Writes reports to binary FILE in the background" )
+    and Commandline::describe( "-quantum=TIME",   "Loosely-timed with global quantum TIME (e.g. 100_ns)" )
+    and Commandline::describe( "-methods",        "Use SC_METHODs instead of SC_THREADs where possible" )
+    and Commandline::describe( "-lanes=K",        "Builds K independent lanes of stimulus to observer (default 1)" )
+  };
+
+  // Matches * (any characters) and ? (one character)
+  bool glob_match( const char* pattern, const char* text )
+  {
+    const char* star   = nullptr;
+    const char* resume = nullptr;
+    while( *text != '\0' ) {
+      if( *pattern == '*' ) {
+        star   = pattern++;
+        resume = text;
+      } else if( *pattern == '?' or *pattern == *text ) {
+        ++pattern;
+        ++text;
+      } else if( star != nullptr ) {
+        pattern = star + 1;
+        text    = ++resume;
+      } else {
+        return false;
+      }
+    }
+    while( *pattern == '*' ) ++pattern;
+    return *pattern == '\0';
+  }
+}
+
 // stimulus -- splitter -- behavior -- observer
 //                     \______________/
+//
+// With -burst or -quantum, the splitter carries Burst<T> transactions instead
+// of samples. Every module carries the payload type T selected by -payload.
+//
+// With -lanes=K, top.lane_0 .. top.lane_<K-1> each hold such a chain and
+// share the objector and the summary.
 
 Top_module::Top_module( sc_module_name instance )
 : sc_module( instance )
 , objector( std::make_unique<Objector_module>         ("objector") )
-, stimulus( std::make_unique<Stimulus_module>         ("stimulus") )
-, splitter( std::make_unique<Splitter_module<Data_t>> ("splitter") )
-, behavior( std::make_unique<Behavior_module>         ("behavior") )
-, observer( std::make_unique<Observer_module>         ("observer") )
 {
+  if( Commandline::has( "-quantum" ) ) {
+    // Loosely-timed: modules synchronize once the quantum is exceeded
+    tlm_utils::tlm_quantumkeeper::set_global_quantum( Commandline::get<sc_time>( "-quantum", 100_ns ) );
+  }
+  if( Commandline::has( "-methods" ) ) {
+    // SC_METHODs cannot suspend when dropping objections
+    if( Commandline::get<std::string>( "-objection", "" ) == "yield" ) {
+      REPORT( WARNING, "-methods requires -objection=deferred; ignoring -objection=yield" );
+    }
+    Objection::set_mode( Objection::Mode::deferred );
+  }
+  // Resolved once, so unknown names are reported once
+  auto payload = Payload_registry::selected();
+  auto kernel  = Kernel_registry::selected();
+  auto count = Commandline::get<size_t>( "-lanes", 1 );
+  if( count == 0 ) {
+    REPORT( WARNING, "Number of lanes (-lanes) should be at least 1" );
+    count = 1;
+  }
+  if( count == 1 ) {
+    lane.build( payload, kernel );
+  } else {
+    lanes.reserve( count );
+    for( size_t i = 0; i != count; ++i ) {
+      auto name = "lane_" + std::to_string( i );
+      lanes.push_back( std::make_unique<Lane_module>( name.c_str(), payload, kernel ) );
+    }
+    INFO( MEDIUM, "Built " << count << " lanes" );
+  }
+
   //----------------------------------------------------------------------------
   // Parse command-line
-  if( Commandline::has_opt( "-trace" ) > 0 and s_self == nullptr ) {
+  Commandline::check();
+  bool windowed = Commandline::has( "-trace-from" ) or Commandline::has( "-trace-to" )
+               or Commandline::has( "-trace-trigger" );
+  if( ( Commandline::has( "-trace" ) or windowed ) and s_self == nullptr ) {
     s_self = this;
   }
-  if( Commandline::has_opt( "-quiet" ) > 0 ) {
+  if( Commandline::has( "-quiet" ) ) {
     sc_report_handler::set_verbosity_level( SC_NONE );
   }
-  if( Commandline::has_opt( "-verbose" ) > 0 ) {
+  if( Commandline::has( "-verbose" ) ) {
     sc_report_handler::set_verbosity_level( SC_HIGH );
   }
-  if( Commandline::has_opt( "-debug" ) > 0 ) {
+  if( Commandline::has( "-debug" ) or Commandline::has( "-debugall" ) ) {
     sc_report_handler::set_verbosity_level( SC_DEBUG );
   }
   sc_report_handler::set_actions( SC_ERROR, SC_DISPLAY | SC_LOG );
+  if( Commandline::has( "-log" ) ) {
+    Log_sink::open( Commandline::get<std::string>( "-log", "run.sclog" ) );
+  }
+}
+
+Lane_module::Lane_module( sc_module_name instance, const std::string& payload, const std::string& kernel )
+: sc_module( instance )
+{
+  lane.build( payload, kernel );
+}
+
+void Lane::build( const std::string& payload, const std::string& kernel )
+{
+  Payload_registry::for_each( [&]( auto value ){
+    using T = decltype( value );
+    if( payload == Payload_registry::name<T>() ) build<T>( kernel );
+  } );
+}
+
+template<typename T>
+void Lane::build( const std::string& kernel )
+{
+  auto stimulus_ = std::make_unique<Stimulus_module<T>>("stimulus");
+  std::unique_ptr<Splitter_module<T>>        splitter_;       // unless -burst
+  std::unique_ptr<Splitter_module<Burst<T>>> burst_splitter_; // if -burst
+  if( Commandline::get<size_t>( "-burst", 1 ) > 1 or Commandline::has( "-quantum" ) ) {
+    burst_splitter_ = std::make_unique<Splitter_module<Burst<T>>>("splitter");
+  } else {
+    splitter_ = std::make_unique<Splitter_module<T>>("splitter");
+  }
+  auto behavior_ = Behavior_base<T>::create( "behavior", kernel );
+  auto observer_ = std::make_unique<Observer_module<T>>( "observer", kernel );
 
   //----------------------------------------------------------------------------
   // Connect everything up
-  splitter->fifo_port.bind    ( stimulus->stim_export    );
-  behavior->recv_port.bind    ( splitter->sig1_export    );
-  behavior->send_port.bind    ( observer->actual_export  );
-  observer->expect_port.bind  ( splitter->sig2_export    );
-  observer->running_port.bind ( stimulus->running_export );
+  if( splitter_ ) {
+    splitter_->fifo_port.bind   ( stimulus_->stim_export   );
+    behavior_->recv_port.bind   ( splitter_->sig_export[0] );
+    behavior_->send_port.bind   ( observer_->actual_export );
+    observer_->expect_port.bind ( splitter_->sig_export[1] );
+    splitter = std::move( splitter_ );
+  } else {
+    burst_splitter_->fifo_port.bind   ( stimulus_->burst_export         );
+    behavior_->burst_recv_port.bind   ( burst_splitter_->sig_export[0]  );
+    behavior_->burst_send_port.bind   ( observer_->burst_actual_export  );
+    observer_->burst_expect_port.bind ( burst_splitter_->sig_export[1]  );
+    splitter = std::move( burst_splitter_ );
+  }
+  observer_->running_port.bind ( stimulus_->running_export );
+  stimulus = std::move( stimulus_ );
+  behavior = std::move( behavior_ );
+  observer = std::move( observer_ );
 }
 
 Top_module::~Top_module() = default;
@@ -52,15 +181,87 @@ void Top_module::end_of_elaboration()
   // If tracing, s_self will point to top-module and
   // we should open the waveform data file.
   if( s_self != nullptr ) {
-    m_trace = sc_create_vcd_trace_file( "dump" );
+    // -trace values other than a format are filters
+    std::string format{ "vcd" };
+    for( const auto& value : Commandline::get_all<std::string>( "-trace" ) ) {
+      if( value == "vcd" or value == "bin" or value == "fst" ) format = value;
+      else m_filters.push_back( value );
+    }
+    if( format == "fst" ) {
+      REPORT( WARNING, "FST is not available; writing the bin format instead" );
+      format = "bin";
+    }
+    bool windowed = Commandline::has( "-trace-from" ) or Commandline::has( "-trace-to" )
+                 or Commandline::has( "-trace-trigger" );
+    if( windowed and format != "bin" ) {
+      REPORT( WARNING, "-trace-from, -trace-to and -trace-trigger need the bin format; using bin" );
+      format = "bin";
+    }
+    if( format == "bin" ) {
+      m_wave = Wave_trace_file::create( "dump" );
+      m_trace_filename = "dump.wave";
+      m_wave->window( Commandline::get<sc_time>( "-trace-from", SC_ZERO_TIME )
+                    , Commandline::get<sc_time>( "-trace-to", sc_max_time() ) );
+      if( Commandline::has( "-trace-trigger" ) ) {
+        m_wave->pretrigger( Commandline::get<sc_time>( "-trace-trigger", 100_ns ) );
+      }
+      m_trace = m_wave;
+    } else {
+      m_trace = sc_create_vcd_trace_file( "dump" );
+      m_trace_filename = "dump.vcd";
+    }
     sc_assert( m_trace != nullptr );
   }
 }
 
+void Top_module::end_of_simulation()
+{
+  Log_sink::flush();
+  if( m_wave != nullptr ) {
+    // Writes the final block and the index
+    Wave_trace_file::close( m_wave );
+    m_trace = m_wave = nullptr;
+  } else if( m_trace != nullptr ) {
+    sc_close_vcd_trace_file( m_trace );
+    m_trace = nullptr;
+  }
+}
+
 sc_core::sc_trace_file* Top_module::trace_file()
 {
   if( s_self == nullptr ) return nullptr;
   return s_self->m_trace;
 }
 
+std::string Top_module::trace_filename()
+{
+  if( s_self == nullptr ) return "";
+  return s_self->m_trace_filename;
+}
+
+bool Top_module::traced( const std::string& name )
+{
+  if( s_self == nullptr or s_self->m_filters.empty() ) return true;
+  for( const auto& filter : s_self->m_filters ) {
+    if( glob_match( filter.c_str(), name.c_str() ) ) return true;
+  }
+  return false;
+}
+
+void Top_module::trace_trigger()
+{
+  if( s_self != nullptr and s_self->m_wave != nullptr ) s_self->m_wave->trigger();
+}
+
+std::string Top_module::lane_file( const std::string& filename, const sc_object* module )
+{
+  auto lane = dynamic_cast<const Lane_module*>( module->get_parent_object() );
+  if( lane == nullptr ) return filename;
+  auto dot = filename.find_last_of( '.' );
+  if( dot == std::string::npos or filename.find_first_of( '/', dot ) != std::string::npos ) {
+    dot = filename.size(); // No extension
+  }
+  return filename.substr( 0, dot ) + "." + lane->basename() + filename.substr( dot );
+}
+
 // TAF!
@@ -2,30 +2,69 @@
 
 #include "systemc.hpp"
 #include "common.hpp"
+#include "burst.hpp"
 #include <memory>
+#include <string>
+#include <vector>
 
 // Forward declarations
 struct Objector_module;
-struct Stimulus_module;
-template<typename T> struct Splitter_module;
-struct Behavior_module;
-struct Observer_module;
+class Wave_trace_file;
+
+// One stimulus -- splitter -- behavior -- observer chain
+struct Lane
+{
+  // Templates on the payload type from -payload (see payload.hpp)
+  std::unique_ptr<sc_core::sc_module> stimulus;
+  std::unique_ptr<sc_core::sc_module> splitter; // Of bursts if -burst
+  std::unique_ptr<sc_core::sc_module> behavior; // Kernel from -kernel
+  std::unique_ptr<sc_core::sc_module> observer;
+  // Creates and connects the modules under the module being constructed
+  void build( const std::string& payload, const std::string& kernel );
+private:
+  template<typename T>
+  void build( const std::string& kernel );
+};
+
+// Holds one of several lanes (-lanes=K)
+struct Lane_module: sc_core::sc_module
+{
+  Lane lane;
+  Lane_module( sc_core::sc_module_name instance, const std::string& payload, const std::string& kernel );
+};
 
 struct Top_module: sc_core::sc_module
 {
-  std::unique_ptr<Objector_module>         objector;
-  std::unique_ptr<Stimulus_module>         stimulus;
-  std::unique_ptr<Splitter_module<Data_t>> splitter;
-  std::unique_ptr<Behavior_module>         behavior;
-  std::unique_ptr<Observer_module>         observer;
+  std::unique_ptr<Objector_module>          objector; // Shared by every lane
+  Lane                                      lane;     // Directly under top unless -lanes
+  std::vector<std::unique_ptr<Lane_module>> lanes;    // lane_0, lane_1, ... if -lanes=K
   // Constructor scans command-line and connects everything
   Top_module( sc_core::sc_module_name );
   ~Top_module();
   // Open trace file if needed
   void end_of_elaboration();
+  // Make sure nothing reported is lost
+  void end_of_simulation();
   // If not nullptr, then return an trace file handle
   static sc_core::sc_trace_file* trace_file();
+  // True unless name is excluded by -trace=GLOB filters
+  static bool traced( const std::string& name );
+  // Traces object if tracing and not filtered out
+  template<typename T>
+  static void trace( const T& object, const std::string& name )
+  {
+    if( auto tf = trace_file(); tf != nullptr and traced( name ) ) sc_trace( tf, object, name );
+  }
+  // Name of the waveform file written, or empty if not tracing
+  static std::string trace_filename();
+  // Failure detected; starts recording if -trace-trigger
+  static void trace_trigger();
+  // filename for module's lane, e.g. run.lane_3.stim (unchanged with one lane)
+  static std::string lane_file( const std::string& filename, const sc_core::sc_object* module );
 private:
-  sc_core::sc_trace_file*   m_trace { nullptr };
-  inline static Top_module* s_self  { nullptr };
+  sc_core::sc_trace_file*   m_trace   { nullptr };
+  Wave_trace_file*          m_wave    { nullptr }; // Same as m_trace if bin format
+  std::string               m_trace_filename;      // e.g. dump.vcd
+  std::vector<std::string>  m_filters;             // From -trace=GLOB
+  inline static Top_module* s_self    { nullptr };
 };
@@ -0,0 +1,281 @@
+// Offline converter from waveforms written by Wave_trace_file (see wave_trace.hpp) to VCD
+//
+// Usage: wave2vcd.x FILE.wave [FROM_NS [TO_NS]] > FILE.vcd
+//
+// Only the blocks overlapping FROM_NS..TO_NS are read and inflated. Does not
+// require SystemC.
+
+#include "wave_format.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+  struct Signal {
+    std::string name;
+    std::string code;   ///< VCD identifier
+    uint8_t     kind;
+    uint32_t    width;
+    uint64_t    value{ 0 };
+    std::string text;
+  };
+
+  struct Change {
+    uint64_t    time;
+    size_t      id;
+    uint64_t    value;
+    std::string text;
+  };
+
+  std::string vcd_code( size_t n )
+  {
+    std::string result;
+    do {
+      result += char( '!' + n % 94 );
+      n /= 94;
+    } while( n != 0 );
+    return result;
+  }
+
+  std::string timescale( uint64_t resolution_fs )
+  {
+    static const char* const units[]{ "fs", "ps", "ns", "us", "ms", "s" };
+    int n = 0;
+    for( auto tr = resolution_fs; tr > 1 and tr % 10 == 0; tr /= 10 ) ++n;
+    if( n >= 15 ) return std::to_string( resolution_fs / 1000000000000000 ) + " s";
+    return std::string( "1" ) + std::string( n % 3, '0' ) + " " + units[ n / 3 ];
+  }
+
+  void print_value( const Signal& signal )
+  {
+    if( signal.kind == Wave_format::real ) {
+      double value;
+      std::memcpy( &value, &signal.value, sizeof( value ) );
+      std::printf( "r%.16g %s\n", value, signal.code.c_str() );
+    } else if( signal.kind == Wave_format::bits ) {
+      if( signal.width == 1 ) {
+        std::printf( "%s%s\n", signal.text.c_str(), signal.code.c_str() );
+      } else {
+        std::printf( "b%s %s\n", signal.text.c_str(), signal.code.c_str() );
+      }
+    } else if( signal.width == 1 ) {
+      std::printf( "%c%s\n", ( signal.value & 1 ) ? '1' : '0', signal.code.c_str() );
+    } else {
+      std::string binary;
+      for( auto value = signal.value; value != 0; value >>= 1 ) binary += char( '0' + ( value & 1 ) );
+      if( binary.empty() ) binary = "0";
+      std::reverse( binary.begin(), binary.end() );
+      std::printf( "b%s %s\n", binary.c_str(), signal.code.c_str() );
+    }
+  }
+
+  void print_header( std::vector<Signal>& signals, uint64_t resolution_fs )
+  {
+    std::printf( "$timescale %s $end\n", timescale( resolution_fs ).c_str() );
+    // Sorting by name keeps each scope contiguous
+    std::vector<size_t> order( signals.size() );
+    for( size_t i = 0; i != order.size(); ++i ) order[ i ] = i;
+    std::sort( order.begin(), order.end(), [&]( size_t l, size_t r ){ return signals[ l ].name < signals[ r ].name; } );
+    std::vector<std::string> scopes;
+    for( auto id : order ) {
+      auto& signal = signals[ id ];
+      signal.code = vcd_code( id );
+      std::vector<std::string> path;
+      size_t begin = 0;
+      for( auto dot = signal.name.find( '.' ); dot != std::string::npos; dot = signal.name.find( '.', begin ) ) {
+        path.push_back( signal.name.substr( begin, dot - begin ) );
+        begin = dot + 1;
+      }
+      size_t common = 0;
+      while( common != scopes.size() and common != path.size() and scopes[ common ] == path[ common ] ) ++common;
+      while( scopes.size() > common ) {
+        std::printf( "$upscope $end\n" );
+        scopes.pop_back();
+      }
+      for( ; common != path.size(); ++common ) {
+        std::printf( "$scope module %s $end\n", path[ common ].c_str() );
+        scopes.push_back( path[ common ] );
+      }
+      const char* type = signal.kind == Wave_format::real ? "real" : "wire";
+      std::printf( "$var %s %u %s %s $end\n", type, signal.width, signal.code.c_str(), signal.name.c_str() + begin );
+    }
+    for( ; not scopes.empty(); scopes.pop_back() ) std::printf( "$upscope $end\n" );
+    std::printf( "$enddefinitions $end\n" );
+  }
+
+  // Reads the payload of the block at the current position, inflated
+  bool read_payload( std::FILE* fp, const Wave_format::Block_header& block
+                   , std::vector<uint8_t>& deflated, std::vector<uint8_t>& payload )
+  {
+    auto& bytes = block.payload == block.raw ? payload : deflated; // Stored or deflated
+    bytes.resize( block.payload );
+    if( not bytes.empty() and std::fread( bytes.data(), bytes.size(), 1, fp ) != 1 ) return false;
+    if( block.payload == block.raw ) return true;
+    payload.resize( block.raw );
+    uLongf inflated = block.raw;
+    return uncompress( payload.data(), &inflated, deflated.data(), deflated.size() ) == Z_OK
+       and inflated == block.raw;
+  }
+
+  bool get_value( const uint8_t*& pos, const uint8_t* end, Signal& signal, uint64_t& value, std::string& text )
+  {
+    uint64_t encoded;
+    if( not Wave_format::get_varint( pos, end, encoded ) ) return false;
+    if( signal.kind != Wave_format::bits ) {
+      value = encoded ^ value;
+      return true;
+    }
+    if( uint64_t( end - pos ) < encoded ) return false;
+    text.assign( reinterpret_cast<const char*>( pos ), encoded );
+    pos += encoded;
+    return true;
+  }
+
+  // Sets signal values from the block snapshot and returns its changes in time order
+  bool decode( const std::vector<uint8_t>& payload, uint32_t changed, uint64_t start_time
+             , std::vector<Signal>& signals, std::vector<Change>& changes )
+  {
+    auto pos = payload.data();
+    auto end = pos + payload.size();
+    for( auto& signal : signals ) {
+      signal.value = 0;
+      if( not get_value( pos, end, signal, signal.value, signal.text ) ) return false;
+    }
+    changes.clear();
+    for( uint32_t i = 0; i != changed; ++i ) {
+      uint64_t id, count;
+      if( not Wave_format::get_varint( pos, end, id ) or id >= signals.size()
+       or not Wave_format::get_varint( pos, end, count ) ) return false;
+      auto& signal = signals[ id ];
+      uint64_t time  = start_time;
+      uint64_t value = signal.value;
+      std::string text;
+      for( uint64_t n = 0; n != count; ++n ) {
+        uint64_t delta;
+        if( not Wave_format::get_varint( pos, end, delta )
+         or not get_value( pos, end, signal, value, text ) ) return false;
+        time += delta;
+        changes.push_back( { time, id, value, text } );
+      }
+    }
+    std::stable_sort( changes.begin(), changes.end(), []( const Change& l, const Change& r ){ return l.time < r.time; } );
+    return true;
+  }
+
+}
+
+int main( int argc, char* argv[] )
+{
+  if( argc < 2 or argc > 4 ) {
+    std::fprintf( stderr, "Usage: %s FILE [FROM_NS [TO_NS]]\n", argv[ 0 ] );
+    return 2;
+  }
+  auto fp = std::fopen( argv[ 1 ], "rb" );
+  if( fp == nullptr ) {
+    std::perror( argv[ 1 ] );
+    return 1;
+  }
+  Wave_format::File_header header{};
+  if( std::fread( &header, sizeof( header ), 1, fp ) != 1
+   or std::memcmp( header.magic, Wave_format::magic, sizeof( header.magic ) ) != 0
+   or header.resolution_fs == 0 ) {
+    std::fprintf( stderr, "Error: %s is not a waveform written by Wave_trace_file\n", argv[ 1 ] );
+    return 1;
+  }
+  std::vector<Signal> signals( header.signals );
+  for( auto& signal : signals ) {
+    Wave_format::Signal_header entry{};
+    if( std::fread( &entry, sizeof( entry ), 1, fp ) != 1 ) {
+      std::fprintf( stderr, "Error: %s is truncated\n", argv[ 1 ] );
+      return 1;
+    }
+    signal.kind  = entry.kind;
+    signal.width = entry.width;
+    signal.name.resize( entry.name_length );
+    if( entry.name_length != 0 and std::fread( signal.name.data(), entry.name_length, 1, fp ) != 1 ) {
+      std::fprintf( stderr, "Error: %s is truncated\n", argv[ 1 ] );
+      return 1;
+    }
+  }
+  auto first_block = std::ftell( fp );
+
+  // Times in ticks
+  auto ticks = [&]( const char* ns ){ return uint64_t( std::strtod( ns, nullptr ) * 1e6 / header.resolution_fs ); };
+
+  // Use the index if the file was completed, otherwise scan the blocks
+  std::vector<Wave_format::Index_entry> index;
+  Wave_format::Footer footer{};
+  if( std::fseek( fp, -long( sizeof( footer ) ), SEEK_END ) == 0
+   and std::fread( &footer, sizeof( footer ), 1, fp ) == 1
+   and std::memcmp( footer.magic, Wave_format::index_magic, sizeof( footer.magic ) ) == 0 ) {
+    index.resize( footer.blocks );
+    std::fseek( fp, long( footer.index_offset ), SEEK_SET );
+    if( std::fread( index.data(), sizeof( Wave_format::Index_entry ), index.size(), fp ) != index.size() ) {
+      index.clear();
+    }
+  } else {
+    std::fprintf( stderr, "Warning: %s has no index; it may be incomplete\n", argv[ 1 ] );
+    std::fseek( fp, first_block, SEEK_SET );
+    Wave_format::Block_header block{};
+    for( auto offset = first_block; std::fread( &block, sizeof( block ), 1, fp ) == 1; offset = std::ftell( fp ) ) {
+      index.push_back( { block.start_time, uint64_t( offset ) } );
+      if( std::fseek( fp, long( block.payload ), SEEK_CUR ) != 0 ) break;
+    }
+  }
+
+  // Recording may have started late (-trace-from or -trace-trigger)
+  uint64_t from = argc > 2 ? ticks( argv[ 2 ] ) : index.empty() ? 0 : index.front().start_time;
+  uint64_t to   = argc > 3 ? ticks( argv[ 3 ] ) : std::numeric_limits<uint64_t>::max();
+
+  // Start from the last block beginning at or before FROM
+  size_t first = 0;
+  while( first + 1 < index.size() and index[ first + 1 ].start_time <= from ) ++first;
+
+  print_header( signals, header.resolution_fs );
+  std::vector<uint8_t> deflated, payload;
+  std::vector<Change>  changes;
+  bool dumped = false;
+  uint64_t time = 0;
+  auto dumpvars = [&]{
+    std::printf( "#%llu\n$dumpvars\n", static_cast<unsigned long long>( from ) );
+    for( const auto& signal : signals ) print_value( signal );
+    std::printf( "$end\n" );
+    dumped = true;
+    time = from;
+  };
+  for( auto block_index = first; block_index < index.size() and index[ block_index ].start_time <= to; ++block_index ) {
+    Wave_format::Block_header block{};
+    std::fseek( fp, long( index[ block_index ].offset ), SEEK_SET );
+    if( std::fread( &block, sizeof( block ), 1, fp ) != 1
+     or not read_payload( fp, block, deflated, payload )
+     or not decode( payload, block.changed, block.start_time, signals, changes ) ) {
+      std::fprintf( stderr, "Warning: %s has a damaged block at offset %llu\n"
+                  , argv[ 1 ], static_cast<unsigned long long>( index[ block_index ].offset ) );
+      break;
+    }
+    for( const auto& change : changes ) {
+      if( change.time > to ) break;
+      if( change.time > from and not dumped ) dumpvars();
+      auto& signal = signals[ change.id ];
+      signal.value = change.value;
+      signal.text  = change.text;
+      if( change.time <= from ) continue; // Part of the initial values
+      if( change.time != time ) {
+        time = change.time;
+        std::printf( "#%llu\n", static_cast<unsigned long long>( time ) );
+      }
+      print_value( signal );
+    }
+  }
+  if( not dumped ) dumpvars();
+  std::fclose( fp );
+  return 0;
+}
+
+//TAF!
@@ -0,0 +1,114 @@
+#pragma once
+
+/** @file wave_format.hpp
+
+@brief Binary layout of waveform files written by Wave_trace_file
+
+Shared by the simulator (wave_trace.cpp) and the converter (wave2vcd.cpp),
+so this header must not depend on SystemC.
+
+A file is laid out as follows (all integers little-endian):
+
+```
+File_header
+Signal_header + name               (one per signal)
+Block_header + payload             (repeated)
+Index_entry                        (one per block)
+Footer
+```
+
+Times are in ticks of `resolution_fs` femtoseconds. Each block is decodable
+on its own. Its payload is deflated with zlib (`compress2()`), unless that
+would not make it smaller, in which case it is stored as is (`payload`
+equals `raw`). Once inflated, the payload is:
+
+- a snapshot of every signal's value at `start_time`, in signal order;
+- for each signal that changed: varint signal id, varint change count, then
+  per change a varint time delta (from the previous change of that signal,
+  or from `start_time`) followed by the value.
+
+Values are encoded by kind: `integer` and `real` as a varint of the bits
+XORed with the previous value (the snapshot is XORed with zero), `bits` as
+a varint length followed by that many characters.
+
+The index at the end maps block start times to file offsets, so a reader
+can seek directly to the block containing a given time.
+
+********************************************************************************
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Wave_format {
+
+  constexpr char magic[ 8 ]{ 'S', 'C', 'W', 'A', 'V', 'E', '2', '\0' };
+  constexpr char index_magic[ 8 ]{ 'S', 'C', 'W', 'I', 'D', 'X', '1', '\0' };
+
+  enum Kind : uint8_t { integer = 1, real = 2, bits = 3 };
+
+  struct File_header {
+    char     magic[ 8 ];
+    uint64_t resolution_fs; ///< Femtoseconds per time tick
+    uint32_t signals;
+    uint32_t reserved;
+  };
+
+  struct Signal_header {
+    uint32_t width;         ///< Bits (characters for `bits`)
+    uint16_t name_length;   ///< Bytes of name that follow
+    uint8_t  kind;
+    uint8_t  is_signed;
+  };
+
+  struct Block_header {
+    uint64_t start_time;
+    uint64_t end_time;      ///< Time of the last change in the block
+    uint32_t changed;       ///< Signals with changes
+    uint32_t payload;       ///< Bytes that follow (deflated)
+    uint32_t raw;           ///< Bytes of the payload once inflated
+    uint32_t reserved;
+  };
+
+  struct Index_entry {
+    uint64_t start_time;
+    uint64_t offset;        ///< Of the Block_header
+  };
+
+  struct Footer {
+    uint64_t index_offset;
+    uint32_t blocks;
+    uint32_t reserved;
+    char     magic[ 8 ];
+  };
+
+  static_assert( sizeof( File_header ) == 24 );
+  static_assert( sizeof( Signal_header ) == 8 );
+  static_assert( sizeof( Block_header ) == 32 );
+  static_assert( sizeof( Index_entry ) == 16 );
+  static_assert( sizeof( Footer ) == 24 );
+
+  inline void put_varint( std::vector<uint8_t>& buffer, uint64_t value )
+  {
+    while( value >= 0x80 ) {
+      buffer.push_back( uint8_t( value ) | 0x80 );
+      value >>= 7;
+    }
+    buffer.push_back( uint8_t( value ) );
+  }
+
+  inline bool get_varint( const uint8_t*& pos, const uint8_t* end, uint64_t& value )
+  {
+    value = 0;
+    for( unsigned shift = 0; pos != end and shift < 64; shift += 7 ) {
+      auto byte = *pos++;
+      value |= uint64_t( byte & 0x7F ) << shift;
+      if( ( byte & 0x80 ) == 0 ) return true;
+    }
+    return false;
+  }
+
+}
+
+// TAF!
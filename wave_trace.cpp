@@ -0,0 +1,376 @@
+#include "wave_trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <zlib.h>
+
+using namespace sc_core;
+
+namespace {
+
+  uint64_t mask( uint32_t width )
+  {
+    return width >= 64 ? ~uint64_t( 0 ) : ( uint64_t( 1 ) << width ) - 1;
+  }
+
+  uint64_t real_bits( double value )
+  {
+    uint64_t result;
+    std::memcpy( &result, &value, sizeof( result ) );
+    return result;
+  }
+
+}
+
+Wave_trace_file* Wave_trace_file::create( const char* name )
+{
+  return new Wave_trace_file( name );
+}
+
+void Wave_trace_file::close( sc_trace_file* tf )
+{
+  delete static_cast<Wave_trace_file*>( tf );
+}
+
+Wave_trace_file::Wave_trace_file( const char* name )
+: sc_trace_file_base( name, "wave" )
+{
+}
+
+Wave_trace_file::~Wave_trace_file()
+{
+  finish();
+}
+
+void Wave_trace_file::window( const sc_time& from, const sc_time& to )
+{
+  m_from = from.value();
+  m_to   = to.value();
+}
+
+void Wave_trace_file::pretrigger( const sc_time& history )
+{
+  m_history = history.value();
+  m_held    = true;
+}
+
+void Wave_trace_file::trigger()
+{
+  if( not m_held ) return;
+  for( const auto& block : m_held_blocks ) {
+    m_index.push_back( { block.start_time, static_cast<uint64_t>( std::ftell( fp ) ) } );
+    std::fwrite( block.bytes.data(), 1, block.bytes.size(), fp );
+  }
+  m_held_blocks.clear();
+  m_held = false;
+}
+
+//------------------------------------------------------------------------------
+// Registration
+
+void Wave_trace_file::add( const void* object, const std::string& name, Wave_format::Kind kind
+                         , int width, bool is_signed, Integer_fn integer, Bits_fn bits )
+{
+  if( not add_trace_check( name ) ) return;
+  Signal signal{};
+  signal.name      = name;
+  signal.kind      = kind;
+  signal.width     = static_cast<uint32_t>( width );
+  signal.is_signed = is_signed;
+  signal.object    = object;
+  signal.integer   = integer;
+  signal.bits      = bits;
+  m_signals.push_back( std::move( signal ) );
+}
+
+template<typename T>
+void Wave_trace_file::add_integer( const T& object, const std::string& name, int width )
+{
+  add( &object, name, Wave_format::integer, width, std::is_signed_v<T>
+     , []( const void* p ){ return uint64_t( *static_cast<const T*>( p ) ); } );
+}
+
+void Wave_trace_file::trace( const sc_event&, const std::string& name )
+{
+  std::string note{ "Events are not recorded: " };
+  note += name;
+  SC_REPORT_WARNING( MSGID, note.c_str() );
+}
+
+void Wave_trace_file::trace( const sc_time& object, const std::string& name )
+{
+  add( &object, name, Wave_format::integer, 64, false
+     , []( const void* p ){ return uint64_t( static_cast<const sc_time*>( p )->value() ); } );
+}
+
+void Wave_trace_file::trace( const bool& object, const std::string& name ) { add_integer( object, name, 1 ); }
+
+void Wave_trace_file::trace( const sc_dt::sc_bit& object, const std::string& name )
+{
+  add( &object, name, Wave_format::integer, 1, false
+     , []( const void* p ){ return uint64_t( static_cast<const sc_dt::sc_bit*>( p )->to_bool() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_logic& object, const std::string& name )
+{
+  add( &object, name, Wave_format::bits, 1, false, nullptr
+     , []( const void* p ){ return std::string( 1, static_cast<const sc_dt::sc_logic*>( p )->to_char() ); } );
+}
+
+void Wave_trace_file::trace( const unsigned char& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const unsigned short& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const unsigned int& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const unsigned long& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const char& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const short& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const int& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const long& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const sc_dt::int64& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+void Wave_trace_file::trace( const sc_dt::uint64& object, const std::string& name, int width ) { add_integer( object, name, width ); }
+
+void Wave_trace_file::trace( const float& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( *static_cast<const float*>( p ) ); } );
+}
+
+void Wave_trace_file::trace( const double& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( *static_cast<const double*>( p ) ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_int_base& object, const std::string& name )
+{
+  add( &object, name, Wave_format::integer, object.length(), true
+     , []( const void* p ){ return uint64_t( static_cast<const sc_dt::sc_int_base*>( p )->to_int64() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_uint_base& object, const std::string& name )
+{
+  add( &object, name, Wave_format::integer, object.length(), false
+     , []( const void* p ){ return uint64_t( static_cast<const sc_dt::sc_uint_base*>( p )->to_uint64() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_signed& object, const std::string& name )
+{
+  if( object.length() <= 64 ) {
+    add( &object, name, Wave_format::integer, object.length(), true
+       , []( const void* p ){ return uint64_t( static_cast<const sc_dt::sc_signed*>( p )->to_int64() ); } );
+  } else {
+    add( &object, name, Wave_format::bits, object.length(), true, nullptr
+       , []( const void* p ){ return static_cast<const sc_dt::sc_signed*>( p )->to_string( sc_dt::SC_BIN_US ); } );
+  }
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_unsigned& object, const std::string& name )
+{
+  if( object.length() <= 64 ) {
+    add( &object, name, Wave_format::integer, object.length(), false
+       , []( const void* p ){ return uint64_t( static_cast<const sc_dt::sc_unsigned*>( p )->to_uint64() ); } );
+  } else {
+    add( &object, name, Wave_format::bits, object.length(), false, nullptr
+       , []( const void* p ){ return static_cast<const sc_dt::sc_unsigned*>( p )->to_string( sc_dt::SC_BIN_US ); } );
+  }
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_fxval& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( static_cast<const sc_dt::sc_fxval*>( p )->to_double() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_fxval_fast& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( static_cast<const sc_dt::sc_fxval_fast*>( p )->to_double() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_fxnum& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( static_cast<const sc_dt::sc_fxnum*>( p )->to_double() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_fxnum_fast& object, const std::string& name )
+{
+  add( &object, name, Wave_format::real, 64, true
+     , []( const void* p ){ return real_bits( static_cast<const sc_dt::sc_fxnum_fast*>( p )->to_double() ); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_bv_base& object, const std::string& name )
+{
+  add( &object, name, Wave_format::bits, object.length(), false, nullptr
+     , []( const void* p ){ return static_cast<const sc_dt::sc_bv_base*>( p )->to_string(); } );
+}
+
+void Wave_trace_file::trace( const sc_dt::sc_lv_base& object, const std::string& name )
+{
+  add( &object, name, Wave_format::bits, object.length(), false, nullptr
+     , []( const void* p ){ return static_cast<const sc_dt::sc_lv_base*>( p )->to_string(); } );
+}
+
+void Wave_trace_file::trace( const unsigned int& object, const std::string& name, const char** )
+{
+  add_integer( object, name, 32 );
+}
+
+void Wave_trace_file::write_comment( const std::string& )
+{
+}
+
+//------------------------------------------------------------------------------
+// Recording
+
+void Wave_trace_file::do_initialize()
+{
+  Wave_format::File_header header{};
+  std::memcpy( header.magic, Wave_format::magic, sizeof( header.magic ) );
+  header.resolution_fs = static_cast<uint64_t>( sc_get_time_resolution().to_seconds() * 1e15 + 0.5 );
+  header.signals       = static_cast<uint32_t>( m_signals.size() );
+  std::fwrite( &header, sizeof( header ), 1, fp );
+  for( const auto& signal : m_signals ) {
+    Wave_format::Signal_header entry{};
+    entry.width       = signal.width;
+    entry.name_length = static_cast<uint16_t>( signal.name.size() );
+    entry.kind        = signal.kind;
+    entry.is_signed   = signal.is_signed;
+    std::fwrite( &entry, sizeof( entry ), 1, fp );
+    std::fwrite( signal.name.data(), 1, entry.name_length, fp );
+  }
+}
+
+bool Wave_trace_file::sample( Signal& signal )
+{
+  if( signal.kind == Wave_format::bits ) {
+    auto text = signal.bits( signal.object );
+    if( text == signal.text ) return false;
+    signal.text = std::move( text );
+    return true;
+  }
+  auto value = signal.integer( signal.object ) & mask( signal.width );
+  if( value == signal.value ) return false;
+  signal.value = value;
+  return true;
+}
+
+void Wave_trace_file::put_value( std::vector<uint8_t>& buffer, Wave_format::Kind kind
+                               , uint64_t value, const std::string& text, uint64_t previous )
+{
+  if( kind == Wave_format::bits ) {
+    Wave_format::put_varint( buffer, text.size() );
+    buffer.insert( buffer.end(), text.begin(), text.end() );
+  } else {
+    Wave_format::put_varint( buffer, value ^ previous );
+  }
+}
+
+void Wave_trace_file::cycle( bool delta_cycle )
+{
+  if( delta_cycle and not delta_cycles() ) return;
+  initialize();
+  if( m_state == State::done ) return;
+  auto now = sc_time_stamp().value();
+  if( m_state == State::waiting ) {
+    if( now < m_from ) return;
+    // Values at the start of the window form the snapshot of the first block
+    for( auto& signal : m_signals ) {
+      sample( signal );
+      signal.start_value = signal.value;
+      signal.start_text  = signal.text;
+    }
+    m_block_start = m_block_end = now;
+    m_state = State::recording;
+    return;
+  }
+  if( now > m_to ) {
+    if( not m_held ) flush_block( m_block_end );
+    m_state = State::done;
+    return;
+  }
+  for( auto& signal : m_signals ) {
+    auto previous = signal.value;
+    if( not sample( signal ) ) continue;
+    auto before = signal.buffer.size();
+    Wave_format::put_varint( signal.buffer, now - ( signal.changes == 0 ? m_block_start : signal.last_change ) );
+    put_value( signal.buffer, signal.kind, signal.value, signal.text, previous );
+    m_buffered += signal.buffer.size() - before;
+    signal.last_change = now;
+    ++signal.changes;
+    m_block_end = now;
+  }
+  // While held, short blocks let the history be trimmed closely
+  if( m_buffered >= block_bytes or ( m_held and now - m_block_start >= m_history / 4 ) ) {
+    flush_block( now );
+  }
+}
+
+void Wave_trace_file::flush_block( uint64_t next_start )
+{
+  m_payload.clear();
+  for( const auto& signal : m_signals ) {
+    put_value( m_payload, signal.kind, signal.start_value, signal.start_text, 0 );
+  }
+  uint32_t changed = 0;
+  for( size_t id = 0; id != m_signals.size(); ++id ) {
+    const auto& signal = m_signals[ id ];
+    if( signal.changes == 0 ) continue;
+    Wave_format::put_varint( m_payload, id );
+    Wave_format::put_varint( m_payload, signal.changes );
+    m_payload.insert( m_payload.end(), signal.buffer.begin(), signal.buffer.end() );
+    ++changed;
+  }
+  // Fastest level: most of the saving is already in the encoding
+  constexpr auto header_bytes = sizeof( Wave_format::Block_header );
+  uLongf deflated = compressBound( uLong( m_payload.size() ) );
+  m_block.resize( header_bytes + deflated );
+  if( compress2( m_block.data() + header_bytes, &deflated, m_payload.data(), uLong( m_payload.size() ), Z_BEST_SPEED ) != Z_OK
+   or deflated >= m_payload.size() ) {
+    deflated = uLongf( m_payload.size() ); // Stored
+    std::copy( m_payload.begin(), m_payload.end(), m_block.begin() + header_bytes );
+  }
+  m_block.resize( header_bytes + deflated );
+  Wave_format::Block_header header{};
+  header.start_time = m_block_start;
+  header.end_time   = m_block_end;
+  header.changed    = changed;
+  header.payload    = static_cast<uint32_t>( deflated );
+  header.raw        = static_cast<uint32_t>( m_payload.size() );
+  std::memcpy( m_block.data(), &header, sizeof( header ) );
+  if( m_held ) {
+    // Keep only the blocks needed to cover the history
+    m_held_blocks.push_back( { m_block_start, m_block } );
+    while( m_held_blocks.size() > 1 and m_held_blocks[ 1 ].start_time + m_history <= next_start ) {
+      m_held_blocks.pop_front();
+    }
+  } else {
+    m_index.push_back( { m_block_start, static_cast<uint64_t>( std::ftell( fp ) ) } );
+    std::fwrite( m_block.data(), 1, m_block.size(), fp );
+  }
+  // Next block starts from the current values
+  for( auto& signal : m_signals ) {
+    signal.start_value = signal.value;
+    signal.start_text  = signal.text;
+    signal.changes     = 0;
+    signal.buffer.clear();
+  }
+  m_block_start = m_block_end = next_start;
+  m_buffered    = 0;
+}
+
+void Wave_trace_file::finish()
+{
+  if( not is_initialized() or fp == nullptr ) return;
+  // A held history that was never triggered is discarded
+  if( m_state == State::recording and not m_held ) flush_block( m_block_end );
+  m_state = State::done;
+  Wave_format::Footer footer{};
+  footer.index_offset = static_cast<uint64_t>( std::ftell( fp ) );
+  footer.blocks       = static_cast<uint32_t>( m_index.size() );
+  std::memcpy( footer.magic, Wave_format::index_magic, sizeof( footer.magic ) );
+  std::fwrite( m_index.data(), sizeof( Wave_format::Index_entry ), m_index.size(), fp );
+  std::fwrite( &footer, sizeof( footer ), 1, fp );
+  std::fflush( fp );
+}
+
+// TAF!
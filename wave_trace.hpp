@@ -0,0 +1,144 @@
+#pragma once
+
+/** @class Wave_trace_file
+
+@brief Compact binary alternative to the VCD trace file
+
+An `sc_trace_file` that records value changes in the binary format
+described in wave_format.hpp: per-signal change lists with delta-encoded
+times and XOR-encoded values, grouped into self-contained blocks of about
+64 KiB that are each deflated with zlib, followed by an index of block
+start times. This is much smaller and cheaper to write than VCD. Use
+wave2vcd.x to convert a file to VCD.
+
+Times are always recorded at the kernel time resolution and
+`set_time_unit()` has no effect. Comments and `sc_event`s are not recorded.
+
+Recording may be limited to a time `window()`. With `pretrigger()`, blocks
+are held in memory and only the most recent history is kept until
+`trigger()` is called (e.g. on the first mismatch); the history is then
+written and recording continues normally. Nothing is sampled before the
+window opens or after it closes.
+
+Usage
+-----
+
+```c++
+auto tf = Wave_trace_file::create( "dump" ); // Writes dump.wave
+sc_trace( tf, signal, "signal" );
+tf->window( 1_ms, 2_ms );                    // Optional
+...simulate...
+Wave_trace_file::close( tf );
+```
+
+********************************************************************************
+*/
+
+#include "systemc.hpp"
+#include "wave_format.hpp"
+#include <sysc/tracing/sc_trace_file_base.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class Wave_trace_file : public sc_core::sc_trace_file_base
+{
+public:
+  static Wave_trace_file* create( const char* name ); ///< Writes name.wave
+  static void close( sc_core::sc_trace_file* tf );    ///< Completes the file
+
+  void window( const sc_core::sc_time& from, const sc_core::sc_time& to ); ///< Records only from..to
+  void pretrigger( const sc_core::sc_time& history ); ///< Holds recording back until trigger()
+  void trigger();                                     ///< Writes the held history, then records
+
+  void trace( const sc_core::sc_event& object, const std::string& name ) override;
+  void trace( const sc_core::sc_time& object, const std::string& name ) override;
+  void trace( const bool& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_bit& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_logic& object, const std::string& name ) override;
+  void trace( const unsigned char& object, const std::string& name, int width ) override;
+  void trace( const unsigned short& object, const std::string& name, int width ) override;
+  void trace( const unsigned int& object, const std::string& name, int width ) override;
+  void trace( const unsigned long& object, const std::string& name, int width ) override;
+  void trace( const char& object, const std::string& name, int width ) override;
+  void trace( const short& object, const std::string& name, int width ) override;
+  void trace( const int& object, const std::string& name, int width ) override;
+  void trace( const long& object, const std::string& name, int width ) override;
+  void trace( const sc_dt::int64& object, const std::string& name, int width ) override;
+  void trace( const sc_dt::uint64& object, const std::string& name, int width ) override;
+  void trace( const float& object, const std::string& name ) override;
+  void trace( const double& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_int_base& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_uint_base& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_signed& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_unsigned& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_fxval& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_fxval_fast& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_fxnum& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_fxnum_fast& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_bv_base& object, const std::string& name ) override;
+  void trace( const sc_dt::sc_lv_base& object, const std::string& name ) override;
+  void trace( const unsigned int& object, const std::string& name, const char** enum_literals ) override;
+  void write_comment( const std::string& comment ) override;
+
+protected:
+  void do_initialize() override;
+  void cycle( bool delta_cycle ) override;
+
+private:
+  explicit Wave_trace_file( const char* name );
+  ~Wave_trace_file() override;
+
+  // Samplers read the traced object as bits or as text
+  using Integer_fn = uint64_t (*)( const void* );
+  using Bits_fn    = std::string (*)( const void* );
+  struct Signal {
+    std::string          name;
+    Wave_format::Kind    kind;
+    uint32_t             width;
+    bool                 is_signed;
+    const void*          object;
+    Integer_fn           integer;
+    Bits_fn              bits;
+    uint64_t             value{ 0 };
+    uint64_t             start_value{ 0 }; ///< At start of block
+    std::string          text;
+    std::string          start_text;
+    uint64_t             last_change{ 0 };
+    uint32_t             changes{ 0 };
+    std::vector<uint8_t> buffer;           ///< Encoded changes in block
+  };
+  void add( const void* object, const std::string& name, Wave_format::Kind kind
+          , int width, bool is_signed, Integer_fn integer, Bits_fn bits = nullptr );
+  template<typename T>
+  void add_integer( const T& object, const std::string& name, int width );
+  bool sample( Signal& signal ); ///< Returns true if changed
+  static void put_value( std::vector<uint8_t>& buffer, Wave_format::Kind kind
+                       , uint64_t value, const std::string& text, uint64_t previous );
+  void flush_block( uint64_t next_start );
+  void finish();
+
+  enum class State { waiting, recording, done };
+  struct Held_block {
+    uint64_t             start_time;
+    std::vector<uint8_t> bytes;      ///< Block_header and payload
+  };
+
+  static constexpr const char* const MSGID{ "/Doulos/Example/wave_trace" };
+  static constexpr size_t block_bytes{ size_t{ 1 } << 16 };
+  std::vector<Signal>                   m_signals;
+  std::vector<Wave_format::Index_entry> m_index;
+  std::vector<uint8_t>                  m_payload; ///< Encoded block, before deflating
+  std::vector<uint8_t>                  m_block;   ///< Block_header and deflated payload
+  uint64_t                              m_block_start{ 0 };
+  uint64_t                              m_block_end{ 0 };
+  size_t                                m_buffered{ 0 };
+  State                                 m_state{ State::waiting };
+  uint64_t                              m_from{ 0 };
+  uint64_t                              m_to{ ~uint64_t( 0 ) };
+  uint64_t                              m_history{ 0 };
+  bool                                  m_held{ false };
+  std::deque<Held_block>                m_held_blocks;
+};
+
+// TAF!